@@ -0,0 +1,131 @@
+// Runs every checksum kernel the CPU supports over the same data and reports the throughput of each.
+// Usage: vpkeditchecksumbenchmark [megabytes]
+// Each kernel hashes one big buffer, and then the same amount of data split into small buffers like
+// the ones entries are usually added from. The bytewise CRC32 and scalar Adler-32 kernels are the
+// original implementations.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vpkedit/detail/Adler32.h>
+#include <vpkedit/detail/CRC32.h>
+
+using namespace vpkedit;
+
+namespace {
+
+/// Small enough to sit in the cache, like a typical material or script
+constexpr std::size_t SMALL_BUFFER_SIZE = 4 * 1024;
+
+/// GCF files store a checksum for every block of this size
+constexpr std::size_t GCF_CHECKSUM_BLOCK_SIZE = 0x8000;
+
+/// Repeats the work until enough time has passed to trust the clock, returns GB/s
+double measure(std::size_t bytesPerRun, const std::function<std::uint32_t()>& run, std::uint32_t& result) {
+	std::size_t runs = 0;
+	const auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed{};
+	do {
+		result = run();
+		runs++;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < 0.5);
+	return static_cast<double>(bytesPerRun * runs) / elapsed.count() / 1e9;
+}
+
+void report(const std::string& name, double bigGBPerSecond, double smallGBPerSecond, std::uint32_t checksum) {
+	std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+	          << std::setw(10) << bigGBPerSecond << " GB/s"
+	          << std::setw(10) << smallGBPerSecond << " GB/s"
+	          << "    checksum " << std::hex << std::setw(8) << std::setfill('0') << checksum << std::dec << std::setfill(' ')
+	          << std::endl;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	const std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 256;
+	std::vector<std::byte> data(megabytes * 1024 * 1024);
+	std::mt19937 random{1337};
+	for (auto& byte : data) {
+		byte = static_cast<std::byte>(random());
+	}
+
+	std::cout << "Hashing " << megabytes << " MiB, as one buffer and as " << SMALL_BUFFER_SIZE << " byte buffers\n" << std::endl;
+	std::cout << std::left << std::setw(32) << "kernel" << std::right << std::setw(15) << "one buffer" << std::setw(15) << "small buffers" << std::endl;
+
+	const auto run = [&data](const std::string& name, const std::function<std::uint32_t(const std::byte*, std::size_t)>& checksumFunc) {
+		std::uint32_t checksum = 0;
+		std::uint32_t ignored = 0;
+		const auto big = ::measure(data.size(), [&] {
+			return checksumFunc(data.data(), data.size());
+		}, checksum);
+		const auto small = ::measure(data.size(), [&] {
+			std::uint32_t combined = 0;
+			for (std::size_t offset = 0; offset < data.size(); offset += SMALL_BUFFER_SIZE) {
+				combined ^= checksumFunc(data.data() + offset, std::min(SMALL_BUFFER_SIZE, data.size() - offset));
+			}
+			return combined;
+		}, ignored);
+		::report(name, big, small, checksum);
+	};
+
+	for (auto [kernel, name] : {
+		std::pair{detail::CRC32Kernel::BYTEWISE, "crc32 (bytewise)"},
+		std::pair{detail::CRC32Kernel::SLICING_BY_16, "crc32 (slicing by 16)"},
+		std::pair{detail::CRC32Kernel::PCLMUL, "crc32 (pclmul)"},
+	}) {
+		if (!detail::isCRC32KernelSupported(kernel)) {
+			std::cout << std::left << std::setw(32) << name << "not supported on this CPU" << std::endl;
+			continue;
+		}
+		run(name, [kernel](const std::byte* buffer, std::size_t len) {
+			return detail::computeCRC32(kernel, buffer, len);
+		});
+	}
+	run("crc32 (parallel)", [](const std::byte* buffer, std::size_t len) {
+		return detail::computeCRC32Parallel(buffer, len);
+	});
+
+	for (auto [kernel, name] : {
+		std::pair{detail::Adler32Kernel::SCALAR, "adler32 (scalar)"},
+		std::pair{detail::Adler32Kernel::SSSE3, "adler32 (ssse3)"},
+		std::pair{detail::Adler32Kernel::AVX2, "adler32 (avx2)"},
+	}) {
+		if (!detail::isAdler32KernelSupported(kernel)) {
+			std::cout << std::left << std::setw(32) << name << "not supported on this CPU" << std::endl;
+			continue;
+		}
+		run(name, [kernel](const std::byte* buffer, std::size_t len) {
+			return detail::computeAdler32(kernel, buffer, len);
+		});
+	}
+
+	// How GCF verification checks each block, before and after
+	const auto gcfBlocks = [](const std::function<std::uint32_t(const std::byte*, std::size_t)>& blockChecksum) {
+		return [blockChecksum](const std::byte* buffer, std::size_t len) {
+			std::uint32_t combined = 0;
+			for (std::size_t offset = 0; offset < len; offset += GCF_CHECKSUM_BLOCK_SIZE) {
+				combined ^= blockChecksum(buffer + offset, std::min(GCF_CHECKSUM_BLOCK_SIZE, len - offset));
+			}
+			return combined;
+		};
+	};
+	run("gcf blocks (bytewise + scalar)", gcfBlocks([](const std::byte* buffer, std::size_t len) {
+		return detail::computeCRC32(detail::CRC32Kernel::BYTEWISE, buffer, len) ^ detail::computeAdler32(detail::Adler32Kernel::SCALAR, buffer, len);
+	}));
+	run("gcf blocks (fused)", gcfBlocks([](const std::byte* buffer, std::size_t len) {
+		auto [crc32, adler32] = detail::computeCRC32AndAdler32(buffer, len);
+		return crc32 ^ adler32;
+	}));
+
+	return 0;
+}
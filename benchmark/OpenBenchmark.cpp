@@ -0,0 +1,115 @@
+// Opens VPKs and GMAs over and over and reports how long parsing their file trees takes.
+// Usage: vpkeditopenbenchmark [pack file...]
+// Without any arguments a VPK and a GMA with many small entries are generated in the temp directory
+// and opened instead. Everything is read from the page cache, so this measures parsing, not the disk.
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <vpkedit/GMA.h>
+#include <vpkedit/VPK.h>
+
+using namespace vpkedit;
+
+namespace {
+
+/// About what a big addon or a game's content VPK has
+constexpr int GENERATED_ENTRY_COUNT = 50000;
+
+void addGeneratedEntries(PackFile& packFile) {
+	std::mt19937 random{1337};
+	for (int i = 0; i < GENERATED_ENTRY_COUNT; i++) {
+		std::vector<std::byte> data(random() % 512 + 1);
+		for (auto& byte : data) {
+			byte = static_cast<std::byte>(random());
+		}
+		packFile.addEntry("materials/generated/dir" + std::to_string(i % 100) + "/file" + std::to_string(i) + ".vmt", std::move(data), {});
+	}
+}
+
+std::string generateVPK(const std::filesystem::path& directory) {
+	const auto path = (directory / "benchmark_dir.vpk").string();
+	PackFileOptions options;
+	options.vpk_generateMD5Entries = true;
+	auto vpk = VPK::createEmpty(path, options);
+	::addGeneratedEntries(*vpk);
+	vpk->bake("", nullptr);
+	return path;
+}
+
+std::string generateGMA(const std::filesystem::path& directory) {
+	// There's no way to create a GMA from scratch, so start from an empty one written by hand
+	const auto path = (directory / "benchmark.gma").string();
+	{
+		std::ofstream out{path, std::ios::binary};
+		out.write("GMAD\x03", 5);
+		const std::uint64_t steamID = 0, timestamp = 0;
+		out.write(reinterpret_cast<const char*>(&steamID), sizeof(steamID));
+		out.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+		out.write("\0benchmark\0description\0author\0", 31);
+		const std::int32_t addonVersion = 1;
+		const std::uint32_t endOfEntries = 0, fileCRC = 0;
+		out.write(reinterpret_cast<const char*>(&addonVersion), sizeof(addonVersion));
+		out.write(reinterpret_cast<const char*>(&endOfEntries), sizeof(endOfEntries));
+		out.write(reinterpret_cast<const char*>(&fileCRC), sizeof(fileCRC));
+	}
+	auto gma = GMA::open(path);
+	::addGeneratedEntries(*gma);
+	gma->bake("", nullptr);
+	return path;
+}
+
+void runBenchmark(const std::string& path) {
+	// Repeat until enough time has passed to trust the clock, the first open warms the page cache
+	std::size_t entryCount = 0;
+	if (auto packFile = PackFile::open(path)) {
+		packFile->runForAllEntries([&entryCount](const std::string&, const Entry&) {
+			entryCount++;
+		}, false);
+	} else {
+		std::cerr << "Failed to open " << path << std::endl;
+		return;
+	}
+	std::size_t runs = 0;
+	const auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed{};
+	do {
+		auto packFile = PackFile::open(path);
+		runs++;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < 1.0);
+
+	const auto millisecondsPerOpen = elapsed.count() * 1000.0 / static_cast<double>(runs);
+	std::cout << std::left << std::setw(48) << std::filesystem::path{path}.filename().string() << std::right
+	          << std::fixed << std::setprecision(2) << std::setw(10) << millisecondsPerOpen << " ms/open"
+	          << "    " << entryCount << " entries, " << runs << " runs" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++) {
+		paths.emplace_back(argv[i]);
+	}
+	if (paths.empty()) {
+		const auto directory = std::filesystem::temp_directory_path() / "vpkedit_open_benchmark";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		std::cout << "Generating a VPK and a GMA with " << GENERATED_ENTRY_COUNT << " entries each\n" << std::endl;
+		paths.push_back(::generateVPK(directory));
+		paths.push_back(::generateGMA(directory));
+	}
+
+	for (const auto& path : paths) {
+		::runBenchmark(path);
+	}
+	return 0;
+}
@@ -0,0 +1,136 @@
+// Reads every entry of a pack file a few different ways and reports the throughput of each.
+// Usage: vpkeditbenchmark <pack file> [--warm]
+// By default the page cache is dropped for the pack file's archives before each run, so the numbers
+// reflect reading from disk. Pass --warm to skip that and measure reads that hit the cache instead.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <vpkedit/PackFile.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace vpkedit;
+
+namespace {
+
+/// Evict every file belonging to the pack file from the page cache, returns false if the platform can't
+bool dropPageCache(const PackFile& packFile) {
+#ifdef __linux__
+	const std::filesystem::path packFilePath{packFile.getFilepath()};
+	const auto stem = packFile.getTruncatedFilestem();
+	std::error_code ec;
+	for (const auto& file : std::filesystem::directory_iterator{packFilePath.parent_path(), ec}) {
+		if (!file.is_regular_file() || !file.path().filename().string().starts_with(stem)) {
+			continue;
+		}
+		int fd = ::open(file.path().c_str(), O_RDONLY);
+		if (fd < 0) {
+			continue;
+		}
+		::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		::close(fd);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+struct Result {
+	std::uint64_t bytes = 0;
+	std::uint64_t failed = 0;
+	/// Summed so the reads can't be optimized out, and to check every method read the same data
+	std::uint64_t checksum = 0;
+};
+
+void addToResult(Result& result, std::span<const std::byte> data) {
+	result.bytes += data.size();
+	for (auto byte : data) {
+		result.checksum += static_cast<std::uint8_t>(byte);
+	}
+}
+
+void runBenchmark(const std::string& name, const std::string& path, PackFileOptions options, bool cold, const std::function<void(const PackFile&, const std::vector<Entry>&, Result&)>& read) {
+	auto packFile = PackFile::open(path, options);
+	if (!packFile) {
+		std::cerr << "Failed to open " << path << std::endl;
+		return;
+	}
+	std::vector<Entry> entries;
+	packFile->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+		entries.push_back(entry);
+	});
+	// Freshly baked pack files store entries in the order they're listed, which nobody reading
+	// a subset of them can count on. Every method gets the same order
+	std::shuffle(entries.begin(), entries.end(), std::mt19937{1337});
+
+	if (cold && !::dropPageCache(*packFile)) {
+		std::cerr << "Dropping the page cache isn't supported on this platform, results will be warm" << std::endl;
+	}
+
+	Result result;
+	const auto start = std::chrono::steady_clock::now();
+	read(*packFile, entries, result);
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	const auto megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+	std::cout << std::left << std::setw(32) << name << std::right
+	          << std::fixed << std::setprecision(3) << std::setw(10) << elapsed.count() << " s"
+	          << std::setprecision(1) << std::setw(10) << (megabytes / elapsed.count()) << " MiB/s"
+	          << "    " << entries.size() << " entries, " << result.failed << " failed, checksum " << result.checksum
+	          << std::endl;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <pack file> [--warm]" << std::endl;
+		return 1;
+	}
+	const std::string path = argv[1];
+	const bool cold = !(argc > 2 && std::string{argv[2]} == "--warm");
+
+	PackFileOptions syncOptions;
+	syncOptions.asyncBatchReads = false;
+	PackFileOptions asyncOptions;
+	asyncOptions.asyncBatchReads = true;
+
+	// One read per entry in the order they were asked for, like callers did before readEntries
+	::runBenchmark("readEntry (one at a time)", path, syncOptions, cold, [](const PackFile& packFile, const std::vector<Entry>& entries, Result& result) {
+		std::vector<std::byte> buffer;
+		for (const auto& entry : entries) {
+			if (packFile.readEntryInto(entry, buffer)) {
+				::addToResult(result, buffer);
+			} else {
+				result.failed++;
+			}
+		}
+	});
+
+	const auto readBatched = [](const PackFile& packFile, const std::vector<Entry>& entries, Result& result) {
+		packFile.readEntries(entries, [&result](const Entry&, std::optional<std::span<const std::byte>> data) {
+			if (data) {
+				::addToResult(result, *data);
+			} else {
+				result.failed++;
+			}
+		});
+	};
+	::runBenchmark("readEntries (synchronous)", path, syncOptions, cold, readBatched);
+	::runBenchmark("readEntries (asynchronous)", path, asyncOptions, cold, readBatched);
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+add_executable(${PROJECT_NAME}benchmark
+        "${CMAKE_CURRENT_LIST_DIR}/ReadBenchmark.cpp")
+
+target_link_libraries(${PROJECT_NAME}benchmark PUBLIC lib${PROJECT_NAME})
+
+target_include_directories(
+        ${PROJECT_NAME}benchmark PRIVATE
+        "${CMAKE_CURRENT_SOURCE_DIR}/include")
+
+add_executable(${PROJECT_NAME}checksumbenchmark
+        "${CMAKE_CURRENT_LIST_DIR}/ChecksumBenchmark.cpp")
+
+target_link_libraries(${PROJECT_NAME}checksumbenchmark PUBLIC lib${PROJECT_NAME})
+
+target_include_directories(
+        ${PROJECT_NAME}checksumbenchmark PRIVATE
+        "${CMAKE_CURRENT_SOURCE_DIR}/include")
+
+add_executable(${PROJECT_NAME}openbenchmark
+        "${CMAKE_CURRENT_LIST_DIR}/OpenBenchmark.cpp")
+
+target_link_libraries(${PROJECT_NAME}openbenchmark PUBLIC lib${PROJECT_NAME})
+
+target_include_directories(
+        ${PROJECT_NAME}openbenchmark PRIVATE
+        "${CMAKE_CURRENT_SOURCE_DIR}/include")
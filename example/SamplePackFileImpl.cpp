@@ -25,8 +25,8 @@ std::unique_ptr<PackFile> EXAMPLE::open(const std::string& path, PackFileOptions
 	auto* example = new EXAMPLE{path, options};
 	auto packFile = std::unique_ptr<PackFile>(example);
 
-	// Here is where you add entries to the entries member variable
-	// It's a map between a directory and a vector of entries
+	// Here is where you add entries to the entries member variable, through insertBakedEntry
+	// Entries are stored compactly, and are rebuilt on demand when something asks for them
 	// Every time an entry is added, the callback should be called if the callback exists
 	std::vector<std::pair<std::string, std::string>> samplePaths{
 		{"a/b/c", "skibidi_toilet.png"},
@@ -41,11 +41,6 @@ std::unique_ptr<PackFile> EXAMPLE::open(const std::string& path, PackFileOptions
 			::toLowerCase(name);
 		}
 
-		// Create the list if it doesn't exist
-		if (!example->entries.contains(dir)) {
-			example->entries[dir] = {};
-		}
-
 		// Use the createNewEntry function to avoid Entry having to friend every single damn class
 		Entry entry = createNewEntry();
 
@@ -71,14 +66,14 @@ std::unique_ptr<PackFile> EXAMPLE::open(const std::string& path, PackFileOptions
 		// This can also be omitted if unused, 0 is the default
 		entry.crc32 = 0;
 
-		// Add the entry to the entries map
-		example->entries[dir].push_back(std::move(entry));
+		// Add the entry to the entry table - this also makes it visible to findEntry
+		example->insertBakedEntry(entry);
 	}
 
 	return packFile;
 }
 
-std::vector<std::string> EXAMPLE::verifyEntryChecksums() const {
+std::vector<std::string> EXAMPLE::verifyEntryChecksums(VerifyOptions options, const VerifyCallback& callback) const {
 	return {};
 }
 
@@ -124,11 +119,7 @@ Entry& EXAMPLE::addEntryInternal(Entry& entry, const std::string& filename_, std
 	// ...
 
 	// Include this verbatim
-	if (!this->unbakedEntries.contains(dir)) {
-		this->unbakedEntries[dir] = {};
-	}
-	this->unbakedEntries.at(dir).push_back(entry);
-	return this->unbakedEntries.at(dir).back();
+	return this->insertUnbakedEntry(dir, entry);
 }
 
 bool EXAMPLE::bake(const std::string& outputDir_, const PackFile::Callback& callback) {
@@ -136,40 +127,21 @@ bool EXAMPLE::bake(const std::string& outputDir_, const PackFile::Callback& call
 	std::string outputDir = this->getBakeOutputDir(outputDir_);
 	std::string outputPath = outputDir + '/' + this->getFilename();
 
-	// Loop over all entries and save them
-	for (const auto& [entryDir, entries] : this->getBakedEntries()) {
-		for (const Entry& entry : entries) {
-			auto binData = this->readEntry(entry);
-			if (!binData) {
-				continue;
-			}
-
-			// Write data here
-			// ...
-
-			// Call the callback
-			if (callback) {
-				callback(entry.getParentPath(), entry);
-			}
+	// Loop over all entries (baked and unbaked) and save them
+	this->runForAllEntries([this, &callback](const std::string& entryDir, const Entry& entry) {
+		auto binData = this->readEntry(entry);
+		if (!binData) {
+			return;
 		}
-	}
-	// Yes this is copy-paste, you could probably turn this into a lambda and call it on both maps
-	for (const auto& [entryDir, entries] : this->getUnbakedEntries()) {
-		for (const Entry& entry : entries) {
-			auto binData = this->readEntry(entry);
-			if (!binData) {
-				continue;
-			}
 
-			// Write data here
-			// ...
+		// Write data here
+		// ...
 
-			// Call the callback
-			if (callback) {
-				callback(entry.getParentPath(), entry);
-			}
+		// Call the callback
+		if (callback) {
+			callback(entryDir, entry);
 		}
-	}
+	});
 
 	// Call this when all the entries have been written to disk
 	this->mergeUnbakedEntries();
@@ -49,6 +49,8 @@ protected:
 	/// If the lump is too big where it is, shift it to the end of the file, otherwise its fine
 	void moveLumpToWritableSpace(int lumpToMove, int newSize);
 
+	[[nodiscard]] std::uint64_t getZIPOffset() const override;
+
 	static const std::string TEMP_ZIP_PATH;
 
 	Header header{};
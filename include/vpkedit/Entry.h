@@ -2,6 +2,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
@@ -60,4 +62,69 @@ private:
 	Entry() = default;
 };
 
+/// The data of an entry, returned by PackFile::readEntryView.
+/// When possible this points straight into the memory-mapped pack file, otherwise it owns a copy of the data.
+/// A mapped view is only valid until the pack file it came from is baked or destroyed
+class EntryView {
+public:
+	EntryView() = default;
+
+	/// Points to data owned by somebody else
+	explicit EntryView(std::span<const std::byte> view_);
+
+	/// Owns the data
+	explicit EntryView(std::vector<std::byte>&& data_);
+
+	/// Returns true if the data points into a memory-mapped file instead of a copy
+	[[nodiscard]] bool isMapped() const;
+
+	[[nodiscard]] std::span<const std::byte> span() const;
+
+	[[nodiscard]] const std::byte* data() const;
+
+	[[nodiscard]] std::size_t size() const;
+
+	[[nodiscard]] bool empty() const;
+
+	[[nodiscard]] const std::byte* begin() const;
+
+	[[nodiscard]] const std::byte* end() const;
+
+	operator std::span<const std::byte>() const; // NOLINT(*-explicit-constructor)
+
+private:
+	std::vector<std::byte> owned;
+	std::span<const std::byte> view;
+	bool mapped = false;
+};
+
+/// Reads the data of an entry a chunk at a time, returned by PackFile::openEntryStream.
+/// It must not outlive the pack file it came from or be used after that pack file is baked
+class EntryReader {
+public:
+	explicit EntryReader(std::uint64_t length_);
+	EntryReader(const EntryReader& other) = delete;
+	EntryReader& operator=(const EntryReader& other) = delete;
+
+	virtual ~EntryReader() = default;
+
+	/// Read up to buffer.size() bytes, returns the number of bytes read (0 at the end of the entry) or std::nullopt on failure
+	[[nodiscard]] std::optional<std::size_t> read(std::span<std::byte> buffer);
+
+	/// Move to a position in the entry, returns false if it's past the end
+	bool seek(std::uint64_t position_);
+
+	[[nodiscard]] std::uint64_t tell() const;
+
+	/// The length of the entry
+	[[nodiscard]] std::uint64_t size() const;
+
+protected:
+	/// Fill the buffer starting at the current position, the buffer never goes past the end of the entry
+	[[nodiscard]] virtual bool readInternal(std::span<std::byte> buffer) = 0;
+
+	std::uint64_t position = 0;
+	std::uint64_t length;
+};
+
 } // namespace vpkedit
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include <vpkedit/PackFile.h>
@@ -76,11 +77,6 @@ protected:
 		std::uint32_t firstindex;
 	};
 
-	struct DirectoryEntry2 {
-		DirectoryEntry entry_real{};
-		std::string filename;
-	};
-
 	struct DirectoryMapHeader {
 		std::uint32_t dummy1;
 		std::uint32_t dummy2;
@@ -117,22 +113,41 @@ public:
 
 	[[nodiscard]] std::optional<std::vector<std::byte>> readEntry(const Entry& entry) const override;
 
-	[[nodiscard]] virtual std::vector<std::string> verifyEntryChecksums() const override;
+	[[nodiscard]] std::optional<EntryView> readEntryView(const Entry& entry) const override;
+
+	[[nodiscard]] std::vector<std::string> verifyEntryChecksums(VerifyOptions options /*= {}*/, const VerifyCallback& callback /*= nullptr*/) const override;
 
 protected:
 	GCF(const std::string& fullFilePath_, PackFileOptions options_);
 
+	[[nodiscard]] bool readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const override;
+
+	/// The blocks holding a baked entry's data as indices into blockdata, sorted by their offset in the entry
+	[[nodiscard]] std::span<const std::uint32_t> getEntryBlocks(const Entry& entry) const;
+
+	// Accepts the next piece of an entry's data, returns false to stop reading
+	using ChunkCallback = std::function<bool(std::span<const std::byte> chunk)>;
+
+	/// Read length bytes of a baked entry starting at offset, following its data blocks in order. The data is read
+	/// into the buffer, and every time the buffer fills up (and once more at the end) the filled part is passed to
+	/// the callback. Returns false if the data couldn't be read, stopping early from the callback isn't a failure
+	[[nodiscard]] bool readEntryChunks(const Entry& entry, std::uint64_t offset, std::uint64_t length, std::span<std::byte> buffer, const ChunkCallback& callback) const;
+
 	Header header{};
 	BlockHeader blockheader{};
 	std::vector<Block> blockdata{};
 	std::vector<std::uint32_t> fragmap{};
 	DirectoryHeader dirheader{};
-	//std::vector<DirectoryEntry2> direntries{};
 	std::vector<DirectoryMapEntry> dirmap_entries{};
 	DataBlockHeader datablockheader{};
 	std::vector<ChecksumMapEntry> chksum_map{};
 	std::vector<std::uint32_t> checksums{};
 
+	/// Directory entry index -> where its blocks start in entryBlocks, with one extra at the end for the last entry
+	std::vector<std::uint32_t> entryBlockStarts{};
+	/// Indices into blockdata, grouped by directory entry and sorted by offset in the entry, built when opening
+	std::vector<std::uint32_t> entryBlocks{};
+
 private:
 	VPKEDIT_REGISTER_PACKFILE_EXTENSION(GCF_EXTENSION, &GCF::open);
 };
@@ -28,6 +28,14 @@ public:
 
 	[[nodiscard]] std::optional<std::vector<std::byte>> readEntry(const Entry& entry) const override;
 
+	[[nodiscard]] std::optional<EntryView> readEntryView(const Entry& entry) const override;
+
+	/// Entries with a stored CRC of 0 were written without one and always pass
+	[[nodiscard]] std::vector<std::string> verifyEntryChecksums(VerifyOptions options /*= {}*/, const VerifyCallback& callback /*= nullptr*/) const override;
+
+	/// Passes if the CRC at the end of the file is 0, it was written without one
+	[[nodiscard]] bool verifyFileChecksum() const override;
+
 	bool bake(const std::string& outputDir_ /*= ""*/, const Callback& callback /*= nullptr*/) override;
 
 protected:
@@ -35,6 +43,10 @@ protected:
 
 	Entry& addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) override;
 
+	[[nodiscard]] bool readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const override;
+
+	[[nodiscard]] std::optional<EntryDataLocation> getEntryDataLocation(const Entry& entry) const override;
+
 	Header header{};
 
 private:
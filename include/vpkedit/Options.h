@@ -17,6 +17,14 @@ struct PackFileOptions {
 	/// if this value is false, filenames will be treated as case-insensitive.
 	bool allowUppercaseLettersInFilenames = false;
 
+	/// How many files holding entry data can be open for reading at once. When the limit is hit the least
+	/// recently used file is closed. Only VPKs split across many archives should need more than the default
+	std::uint32_t maxOpenArchives = 16;
+
+	/// Let PackFile::readEntries queue many reads with the kernel at once (io_uring on Linux). When this is
+	/// false, or the kernel doesn't allow it, each read is made synchronously instead
+	bool asyncBatchReads = true;
+
 	/// GMA - Write CRCs for files and the overall GMA file when baking
 	bool gma_writeCRCs = true;
 
@@ -30,6 +38,30 @@ struct PackFileOptions {
 
 	/// VPK - Controls generation of per-file MD5 hashes (only for VPK v2)
 	bool vpk_generateMD5Entries = false;
+
+	/// VPK - Makes verifyFileChecksum also check every per-file MD5 hash against the data it covers, which means
+	/// reading all of it (only for VPK v2)
+	bool vpk_verifyMD5Entries = false;
+
+	/// VPK - How many threads VPK::createFromDirectory finds and hashes files on, 0 uses one per hardware thread.
+	/// The VPK it creates is the same no matter how many threads are used
+	std::uint32_t vpk_createFromDirectoryThreads = 0;
+};
+
+struct ExtractOptions {
+	/// How many threads to extract entries on, 0 uses one per hardware thread
+	std::uint32_t threads = 0;
+
+	/// Entries up to this size are read and written in one go, bigger ones are copied a chunk of this size at a time
+	std::uint32_t bufferSize = 4 * 1024 * 1024;
+};
+
+struct VerifyOptions {
+	/// How many threads to verify entries on, 0 uses one per hardware thread
+	std::uint32_t threads = 0;
+
+	/// Entries up to this size are read and checked in one go, bigger ones are checked a chunk of this size at a time
+	std::uint32_t bufferSize = 4 * 1024 * 1024;
 };
 
 struct EntryOptions {
@@ -2,18 +2,25 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "detail/EntryTable.h"
+#include "detail/FileHandlePool.h"
+#include "detail/MappedFile.h"
 #include "Entry.h"
 #include "Options.h"
 #include "PackFileType.h"
 
 namespace vpkedit {
 
+/// Const functions are safe to call from any number of threads at once, as long as no non-const
+/// function (adding or removing entries, baking, etc.) runs at the same time
 class PackFile {
 public:
 	PackFile(const PackFile& other) = delete;
@@ -26,6 +33,20 @@ public:
 	// Accepts the entry parent directory and the entry metadata
 	using Callback = std::function<void(const std::string& directory, const Entry& entry)>;
 
+	// Accepts the entry metadata and its data, or std::nullopt if it couldn't be read
+	using ReadCallback = std::function<void(const Entry& entry, std::optional<std::span<const std::byte>> data)>;
+
+	// Accepts the entry metadata, returns true if the entry should be included
+	using EntryPredicate = std::function<bool(const Entry& entry)>;
+
+	// Accepts the entry metadata, whether it was extracted successfully, and how many entries are done out of the total.
+	// Returns false to cancel the extraction
+	using ExtractCallback = std::function<bool(const Entry& entry, bool success, std::size_t entriesDone, std::size_t entriesTotal)>;
+
+	// Accepts the entry metadata, whether its checksum matched, and how many entries are done out of the total.
+	// Returns false to cancel the verification
+	using VerifyCallback = std::function<bool(const Entry& entry, bool valid, std::size_t entriesDone, std::size_t entriesTotal)>;
+
 	/// Open a generic pack file. The parser is selected based on the file extension
 	[[nodiscard]] static std::unique_ptr<PackFile> open(const std::string& path, PackFileOptions options = {}, const Callback& callback = nullptr);
 
@@ -36,8 +57,10 @@ public:
 	[[nodiscard]] PackFileOptions getOptions() const;
 
 	/// Verify the checksums of each file, if a file fails the check its filename will be added to the vector.
-	/// If there is no checksum ability in the format, it will return an empty vector
-	[[nodiscard]] virtual std::vector<std::string> verifyEntryChecksums() const;
+	/// If there is no checksum ability in the format, it will return an empty vector. Formats that can check their
+	/// entries do so on several threads, calling the callback once per entry and never from two threads at once.
+	/// If the verification is cancelled only the entries checked so far are reported
+	[[nodiscard]] virtual std::vector<std::string> verifyEntryChecksums(VerifyOptions options = {}, const VerifyCallback& callback = nullptr) const;
 
 	/// Verify the checksum of the entire file, returns true on success
 	/// Will return true if there is no checksum ability in the format
@@ -49,9 +72,47 @@ public:
 	/// Try to read the entry's data to a bytebuffer
 	[[nodiscard]] virtual std::optional<std::vector<std::byte>> readEntry(const Entry& entry) const = 0;
 
+	/// Try to read the entry's data into a buffer at least entry.length bytes long, returns true on success.
+	/// Reusing the same buffer for many reads avoids allocating for each one
+	[[nodiscard]] bool readEntryInto(const Entry& entry, std::span<std::byte> buffer) const;
+
+	/// Try to read the entry's data into a vector, resizing it to fit - its capacity is kept between reads
+	[[nodiscard]] bool readEntryInto(const Entry& entry, std::vector<std::byte>& buffer) const;
+
+	/// Try to read part of the entry's data, e.g. just a file header, without reading the rest of it.
+	/// The range is cut short if it goes past the end of the entry
+	[[nodiscard]] std::optional<std::vector<std::byte>> readEntryRange(const Entry& entry, std::uint64_t offset, std::uint64_t length) const;
+
+	/// Try to read part of the entry's data into a buffer, the range must lie within the entry
+	[[nodiscard]] bool readEntryRangeInto(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const;
+
+	/// Try to get the entry's data without copying it. Stored data is returned straight from the memory-mapped
+	/// file where the format allows it, otherwise (e.g. compressed data) the returned view owns a copy
+	[[nodiscard]] virtual std::optional<EntryView> readEntryView(const Entry& entry) const;
+
+	/// Read many entries at once. Reads are sorted by where the data is stored and nearby entries are read
+	/// together, so the callback is not called in the order the entries were given. The data passed to the
+	/// callback is only valid until it returns. Where the platform supports it several reads are in flight
+	/// at once (see PackFileOptions::asyncBatchReads)
+	void readEntries(std::span<const Entry> entries_, const ReadCallback& callback) const;
+
+	/// Open the entry's data to be read a chunk at a time, so even huge entries can be processed in constant memory
+	[[nodiscard]] virtual std::unique_ptr<EntryReader> openEntryStream(const Entry& entry) const;
+
 	/// Try to read the entry's data to a string
 	[[nodiscard]] std::optional<std::string> readEntryText(const Entry& entry) const;
 
+	/// Write the entry's data to a file, returns true on success
+	bool extractEntry(const Entry& entry, const std::string& filePath) const;
+
+	/// Write every entry the predicate accepts into the output directory, keeping their paths. Entries are extracted
+	/// on several threads in the order their data is stored. The callback is called once per entry, never from two
+	/// threads at once. Returns false if any entry failed or the extraction was cancelled
+	bool extractIf(const std::string& outputDir, const EntryPredicate& predicate, ExtractOptions options = {}, const ExtractCallback& callback = nullptr) const;
+
+	/// Write every entry into the output directory, keeping their paths. See extractIf
+	bool extractAll(const std::string& outputDir, ExtractOptions options = {}, const ExtractCallback& callback = nullptr) const;
+
 	[[nodiscard]] virtual bool isReadOnly() const;
 
 	/// Add a new entry from a file path - the first parameter is the path in the PackFile, the second is the path on disk
@@ -69,12 +130,16 @@ public:
 	/// If output folder is unspecified, it will overwrite the original
 	virtual bool bake(const std::string& outputDir_ /*= ""*/, const Callback& callback /*= nullptr*/) = 0;
 
-	/// Get entries saved to disk
+	/// Get entries saved to disk. Entries are stored compactly internally, so the first call after
+	/// opening or modifying the pack file builds this map - prefer findEntry or runForAllEntries
 	[[nodiscard]] const std::unordered_map<std::string, std::vector<Entry>>& getBakedEntries() const;
 
 	/// Get entries that have been added but not yet baked
 	[[nodiscard]] const std::unordered_map<std::string, std::vector<Entry>>& getUnbakedEntries() const;
 
+	/// Run a function over every entry without building the map returned by getBakedEntries
+	void runForAllEntries(const Callback& operation, bool includeUnbaked = true) const;
+
 	/// Get the number of entries in the pack file
 	[[nodiscard]] std::size_t getEntryCount(bool includeUnbaked = true) const;
 
@@ -104,14 +169,74 @@ protected:
 
 	virtual Entry& addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) = 0;
 
+	/// Fill the buffer with the entry's data starting at the given offset, the range is already known to lie
+	/// within the entry. By default this copies out of the result of readEntry, formats should only read
+	/// what was asked for
+	[[nodiscard]] virtual bool readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const;
+
+	/// Where the data of a baked entry is stored, when it's in one piece in one file
+	struct EntryDataLocation {
+		std::uint16_t archiveIndex;
+		std::uint64_t offset;
+		/// Data kept in memory that goes in front of the data in the file (VPK preloaded data)
+		std::span<const std::byte> prefix;
+	};
+
+	/// Used by readEntries to batch reads - entries without a location are read one at a time
+	[[nodiscard]] virtual std::optional<EntryDataLocation> getEntryDataLocation(const Entry& entry) const;
+
+	/// Accepts an entry and a buffer it may reuse between entries, returns true if the entry's checksum matched
+	using EntryChecker = std::function<bool(const Entry& entry, std::vector<std::byte>& buffer)>;
+
+	/// Run the checker over the entries on several threads, taking them in the order given. Returns the paths of
+	/// the entries that failed in that same order. See verifyEntryChecksums
+	[[nodiscard]] std::vector<std::string> verifyEntriesInParallel(std::span<const Entry> entries_, const EntryChecker& checker, VerifyOptions options, const VerifyCallback& callback) const;
+
+	/// Copy the data stored for an unbaked entry, starting at the given offset into that data
+	[[nodiscard]] bool readUnbakedEntryInto(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const;
+
+	/// Add a baked entry to the entry table
+	void insertBakedEntry(const Entry& entry);
+
+	/// Add an unbaked entry to its parent directory and the path index
+	Entry& insertUnbakedEntry(const std::string& dir, Entry entry);
+
 	[[nodiscard]] std::string getBakeOutputDir(const std::string& outputDir) const;
 
+	/// Path to the file on disk holding the data for the given archive index. Only VPK splits
+	/// its data across multiple files, other formats store everything in the pack file itself
+	[[nodiscard]] virtual std::string getArchiveFilepath(std::uint16_t archiveIndex) const;
+
+	/// Memory-map the file holding the data for the given archive index. The mapping is kept
+	/// until closeArchives is called, which must happen before any of these files are written to
+	[[nodiscard]] const detail::MappedFile* getMappedArchive(std::uint16_t archiveIndex) const;
+
+	/// Get a handle to the file holding the data for the given archive index, or nullptr if it can't be opened.
+	/// The file stays open in a pool shared by every reader until closeArchives is called
+	[[nodiscard]] std::shared_ptr<detail::FileHandle> getArchiveHandle(std::uint16_t archiveIndex) const;
+
+	/// Read a range of the file holding the data for the given archive index, fails if the range is out of bounds
+	[[nodiscard]] bool readArchiveInto(std::uint16_t archiveIndex, std::uint64_t offset, std::span<std::byte> buffer) const;
+
+	/// Write the entry's data to a file. Entries up to the buffer size are read in one go, bigger ones are streamed.
+	/// Data stored as-is in an archive is copied straight from file to file where the platform allows it
+	[[nodiscard]] bool writeEntryToFile(const Entry& entry, const std::string& filePath, std::vector<std::byte>& buffer, std::size_t bufferSize) const;
+
+	/// Drop all mappings and open handles
+	void closeArchives();
+
+	/// Build every baked entry, e.g. to rewrite their offsets in bake - pass them back to insertBakedEntry after clearing the table
+	[[nodiscard]] std::vector<Entry> copyBakedEntries() const;
+
 	void mergeUnbakedEntries();
 
 	void setFullFilePath(const std::string& outputDir);
 
 	[[nodiscard]] static Entry createNewEntry();
 
+	/// An unbaked entry whose data is read from the given file when baking
+	[[nodiscard]] static Entry createUnbakedFileEntry(const std::string& pathToFile);
+
 	[[nodiscard]] static const std::variant<std::string, std::vector<std::byte>>& getEntryUnbakedData(const Entry& entry);
 
 	[[nodiscard]] static bool isEntryUnbakedUsingByteBuffer(const Entry& entry);
@@ -121,9 +246,55 @@ protected:
 	PackFileType type = PackFileType::UNKNOWN;
 	PackFileOptions options;
 
-	std::unordered_map<std::string, std::vector<Entry>> entries;
+	/// Baked entries, including the full path index
+	detail::EntryTable entries;
 	std::unordered_map<std::string, std::vector<Entry>> unbakedEntries;
 
+	/// Hashes an entry path the same way findEntry would normalize it (slashes and letter case
+	/// are folded on the fly), so lookups never need to allocate a normalized copy
+	struct EntryPathHash {
+		using is_transparent = void;
+		[[nodiscard]] std::size_t operator()(std::string_view path) const noexcept;
+	};
+
+	/// Compares entry paths like EntryPathHash hashes them, case-sensitive only when uppercase letters are allowed
+	struct EntryPathEqual {
+		using is_transparent = void;
+		bool caseSensitive = false;
+		[[nodiscard]] bool operator()(std::string_view lhs, std::string_view rhs) const noexcept;
+	};
+
+	/// Where an unbaked entry lives - the directory vector is owned by unbakedEntries
+	struct EntryLocation {
+		std::vector<Entry>* directory;
+		std::size_t index;
+	};
+
+	using EntryIndex = std::unordered_map<std::string, EntryLocation, EntryPathHash, EntryPathEqual>;
+
+	/// Full path -> unbaked entry, kept in sync with unbakedEntries
+	EntryIndex unbakedEntryIndex;
+
+	/// A mutex that doesn't get in the way of moving the pack file, the moved-to object just gets a new one
+	struct CacheMutex : std::mutex {
+		CacheMutex() = default;
+		CacheMutex(CacheMutex&&) noexcept {}
+		CacheMutex& operator=(CacheMutex&&) noexcept { return *this; }
+	};
+
+	/// Guards everything const functions build on demand: mappedArchives and bakedEntriesCache
+	mutable CacheMutex cacheMutex;
+
+	/// Archive index -> mapping, filled on demand by getMappedArchive
+	mutable std::unordered_map<std::uint16_t, detail::MappedFile> mappedArchives;
+
+	/// Archive index -> handle, filled on demand by getArchiveHandle
+	mutable detail::FileHandlePool archiveHandles;
+
+	/// Built on demand by getBakedEntries
+	mutable std::unordered_map<std::string, std::vector<Entry>> bakedEntriesCache;
+	mutable bool bakedEntriesCacheValid = false;
+
 	using FactoryFunction = std::function<std::unique_ptr<PackFile>(const std::string& path, PackFileOptions options, const Callback& callback)>;
 
 	static std::unordered_map<std::string, FactoryFunction>& getExtensionRegistry();
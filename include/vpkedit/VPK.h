@@ -68,6 +68,12 @@ public:
 
     [[nodiscard]] std::optional<std::vector<std::byte>> readEntry(const Entry& entry) const override;
 
+    [[nodiscard]] std::optional<EntryView> readEntryView(const Entry& entry) const override;
+
+	[[nodiscard]] std::vector<std::string> verifyEntryChecksums(VerifyOptions options /*= {}*/, const VerifyCallback& callback /*= nullptr*/) const override;
+
+	[[nodiscard]] bool verifyFileChecksum() const override;
+
     bool bake(const std::string& outputDir_ /*= ""*/, const Callback& callback /*= nullptr*/) override;
 
 	[[nodiscard]] std::string getTruncatedFilestem() const override;
@@ -85,8 +91,23 @@ protected:
 
 	Entry& addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) override;
 
+	/// Pick an archive for an entry that already has its length, CRC and preloaded data filled in, and add it
+	Entry& addPreparedEntry(Entry& entry, const std::string& filename_, bool saveToDirectory);
+
+	[[nodiscard]] bool readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const override;
+
+	[[nodiscard]] std::string getArchiveFilepath(std::uint16_t archiveIndex) const override;
+
+	[[nodiscard]] std::optional<EntryDataLocation> getEntryDataLocation(const Entry& entry) const override;
+
 	[[nodiscard]] std::uint32_t getHeaderLength() const;
 
+	/// Check each MD5 entry against the data it covers, on several threads
+	[[nodiscard]] bool verifyMD5Entries() const;
+
+	/// Where the non-preloaded data of a baked entry starts in its archive
+	[[nodiscard]] std::uint64_t getEntryDataOffset(const Entry& entry) const;
+
 	int numArchives = -1;
 	std::uint32_t currentlyFilledChunkSize = 0;
 
@@ -96,6 +117,9 @@ protected:
 
     std::vector<MD5Entry> md5Entries;
 
+	/// Full path -> MD5 of an unbaked entry's data, when it was already hashed as it was added
+	std::unordered_map<std::string, std::array<std::byte, 16>> unbakedEntryMD5s;
+
 private:
 	VPKEDIT_REGISTER_PACKFILE_EXTENSION(VPK_EXTENSION, &VPK::open);
 };
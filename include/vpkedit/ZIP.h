@@ -1,11 +1,19 @@
 #pragma once
 
+#include <cstdint>
+#include <mutex>
 #include <string_view>
 
 #include <vpkedit/PackFile.h>
 
 namespace vpkedit {
 
+namespace detail {
+
+class ZIPReader;
+
+} // namespace detail
+
 constexpr std::string_view ZIP_EXTENSION = ".zip";
 
 class ZIP : public PackFile {
@@ -17,6 +25,12 @@ public:
 
 	[[nodiscard]] std::optional<std::vector<std::byte>> readEntry(const Entry& entry) const override;
 
+	[[nodiscard]] std::optional<EntryView> readEntryView(const Entry& entry) const override;
+
+	[[nodiscard]] std::unique_ptr<EntryReader> openEntryStream(const Entry& entry) const override;
+
+	[[nodiscard]] std::vector<std::string> verifyEntryChecksums(VerifyOptions options /*= {}*/, const VerifyCallback& callback /*= nullptr*/) const override;
+
 	bool bake(const std::string& outputDir_ /*= ""*/, const Callback& callback /*= nullptr*/) override;
 
 protected:
@@ -24,20 +38,45 @@ protected:
 
 	Entry& addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) override;
 
+	[[nodiscard]] bool readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const override;
+
+	[[nodiscard]] std::optional<EntryDataLocation> getEntryDataLocation(const Entry& entry) const override;
+
 	bool bakeTempZip(const std::string& writeZipPath, const Callback& callback);
 
+	/// Add every file in the open ZIP as a baked entry
+	bool loadEntries(const Callback& callback);
+
+	/// The data of an entry stored without compression, straight from the memory-mapped file
+	[[nodiscard]] std::optional<std::span<const std::byte>> getStoredEntryData(const Entry& entry) const;
+
+	/// Where the ZIP starts inside the file on disk
+	[[nodiscard]] virtual std::uint64_t getZIPOffset() const;
+
+	/// minizip handles keep track of the entry being read, so each thread decoding an entry borrows a reader of its own
+	[[nodiscard]] std::unique_ptr<detail::ZIPReader> acquireZIPReader() const;
+
+	void releaseZIPReader(std::unique_ptr<detail::ZIPReader> reader) const;
+
 	bool openZIP(std::string_view path);
 
 	void closeZIP();
 
 	static const std::string TEMP_ZIP_PATH;
 
+	/// The file minizip has open, which isn't always the pack file itself
+	std::string zipPath;
+
 	void* streamHandle = nullptr;
 	bool streamOpen = false;
 
 	void* zipHandle = nullptr;
 	bool zipOpen = false;
 
+	/// Readers not currently borrowed by any thread
+	mutable std::vector<std::unique_ptr<detail::ZIPReader>> idleZIPReaders;
+	mutable std::mutex zipReadersMutex;
+
 private:
 	VPKEDIT_REGISTER_PACKFILE_EXTENSION(ZIP_EXTENSION, &ZIP::open);
 };
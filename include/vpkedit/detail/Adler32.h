@@ -2,12 +2,36 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace vpkedit::detail {
 
+/// The ways an Adler-32 checksum can be computed, from slowest to fastest
+enum class Adler32Kernel {
+	/// zlib's loop, sixteen bytes unrolled
+	SCALAR,
+	/// 32 bytes at a time in 128-bit registers (x86-64 with SSSE3)
+	SSSE3,
+	/// 32 bytes at a time in 256-bit registers (x86-64 with AVX2)
+	AVX2,
+};
+
+/// Whether the CPU this is running on can use the given kernel
+[[nodiscard]] bool isAdler32KernelSupported(Adler32Kernel kernel);
+
+/// The fastest kernel the CPU supports, which computeAdler32 uses
+[[nodiscard]] Adler32Kernel getAdler32Kernel();
+
 std::uint32_t computeAdler32(const std::vector<std::byte>& buffer, std::uint32_t adler = 0);
 
 std::uint32_t computeAdler32(const std::byte* buffer, std::size_t len, std::uint32_t adler = 0);
 
+/// Compute the checksum with a specific kernel, which must be supported
+std::uint32_t computeAdler32(Adler32Kernel kernel, const std::byte* buffer, std::size_t len, std::uint32_t adler = 0);
+
+/// Compute the CRC32 and Adler-32 of a buffer in one pass, a small slice at a time so the slice
+/// is still in the cache for the second checksum. Returns {crc32, adler32}
+std::pair<std::uint32_t, std::uint32_t> computeCRC32AndAdler32(const std::byte* buffer, std::size_t len, std::uint32_t crc32 = 0, std::uint32_t adler = 0);
+
 } // namespace vpkedit::detail
@@ -44,8 +44,35 @@ constexpr std::array<unsigned int, 256> CRC_TABLE = {
     0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
 };
 
+/// The ways a CRC can be computed, from slowest to fastest
+enum class CRC32Kernel {
+	/// One table lookup per byte
+	BYTEWISE,
+	/// Sixteen table lookups per 16 bytes, which don't depend on each other
+	SLICING_BY_16,
+	/// Carryless multiplication folding 64 bytes at a time (x86-64 with PCLMULQDQ and SSE4.1)
+	PCLMUL,
+};
+
+/// Whether the CPU this is running on can use the given kernel
+[[nodiscard]] bool isCRC32KernelSupported(CRC32Kernel kernel);
+
+/// The fastest kernel the CPU supports, which computeCRC32 uses
+[[nodiscard]] CRC32Kernel getCRC32Kernel();
+
 std::uint32_t computeCRC32(const std::vector<std::byte>& buffer);
 
-std::uint32_t computeCRC32(const std::byte* buffer, std::size_t len);
+/// Pass the CRC of the data before this buffer to continue it, e.g. when reading a file a chunk at a time
+std::uint32_t computeCRC32(const std::byte* buffer, std::size_t len, std::uint32_t previousCRC = 0);
+
+/// Compute the CRC with a specific kernel, which must be supported
+std::uint32_t computeCRC32(CRC32Kernel kernel, const std::byte* buffer, std::size_t len, std::uint32_t previousCRC = 0);
+
+/// Get the CRC of two pieces of data back to back from the CRC of each, and the length of the second
+std::uint32_t combineCRC32(std::uint32_t firstCRC, std::uint32_t secondCRC, std::uint64_t secondLen);
+
+/// Split a big buffer between threads and combine the CRC of each piece. Pass 0 threads to use one per hardware thread.
+/// Buffers too small to be worth splitting are done on this thread
+std::uint32_t computeCRC32Parallel(const std::byte* buffer, std::size_t len, std::uint32_t threads = 0);
 
 } // namespace vpkedit::detail
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vpkedit {
+
+class Entry;
+
+} // namespace vpkedit
+
+namespace vpkedit::detail {
+
+/// Hash an entry path, folding slashes and letter case so unnormalized input can find normalized paths
+[[nodiscard]] std::size_t hashEntryPath(std::string_view path);
+
+/// Compare two entry paths the same way hashEntryPath hashes them
+[[nodiscard]] bool compareEntryPaths(std::string_view lhs, std::string_view rhs, bool caseSensitive);
+
+/// Compact storage for baked entries.
+/// Paths live in one string pool, common fields in parallel arrays, and format-specific fields
+/// in columns that stay empty until an entry actually needs them. Entry objects are only built
+/// when somebody asks for one.
+class EntryTable {
+public:
+	using Row = std::uint32_t;
+
+	explicit EntryTable(bool caseSensitive = false);
+
+	/// Append an entry, returns its row
+	Row add(const Entry& entry);
+
+	/// Remove a row - it keeps its number but is skipped from then on
+	void remove(Row row);
+
+	void clear();
+
+	/// Find a row by path, the path does not need to be normalized
+	[[nodiscard]] std::optional<Row> find(std::string_view path) const;
+
+	/// Copy the fields of a row into an entry
+	void get(Row row, Entry& entry) const;
+
+	/// Includes removed rows, so rows are numbered from 0 to getRowCount() - 1
+	[[nodiscard]] std::size_t getRowCount() const;
+
+	/// Excludes removed rows
+	[[nodiscard]] std::size_t getEntryCount() const;
+
+	[[nodiscard]] bool isRemoved(Row row) const;
+
+	[[nodiscard]] std::string_view getPath(Row row) const;
+
+	/// "materials/cable.vmt" -> "materials"
+	[[nodiscard]] std::string_view getParentPath(Row row) const;
+
+	[[nodiscard]] std::uint64_t getLength(Row row) const;
+
+	[[nodiscard]] std::uint64_t getOffset(Row row) const;
+
+	[[nodiscard]] std::uint64_t getCompressedLength(Row row) const;
+
+	[[nodiscard]] std::uint32_t getCRC32(Row row) const;
+
+	[[nodiscard]] std::uint16_t getArchiveIndex(Row row) const;
+
+	[[nodiscard]] std::span<const std::byte> getPreloadedData(Row row) const;
+
+	[[nodiscard]] std::uint16_t getCompressionMethod(Row row) const;
+
+	/// Call a function with every row that has not been removed
+	template<typename Func>
+	void forEach(Func&& func) const {
+		for (Row row = 0; row < this->getRowCount(); row++) {
+			if (!this->isRemoved(row)) {
+				func(row);
+			}
+		}
+	}
+
+	/// Bytes allocated by the table, including the path index
+	[[nodiscard]] std::size_t getMemoryUsage() const;
+
+private:
+	/// A column that stays empty until a row stores something other than the default value
+	template<typename T, T Default = T{}>
+	struct SparseColumn {
+		std::vector<T> values;
+
+		void push(std::size_t row, T value) {
+			if (this->values.empty()) {
+				if (value == Default) {
+					return;
+				}
+				this->values.resize(row, Default);
+			}
+			this->values.push_back(value);
+		}
+
+		[[nodiscard]] T operator[](std::size_t row) const {
+			return this->values.empty() ? Default : this->values[row];
+		}
+	};
+
+	void insertIntoIndex(Row row);
+
+	void removeFromIndex(Row row);
+
+	void growIndex();
+
+	bool caseSensitive;
+
+	std::string pathPool;
+	std::vector<std::uint32_t> pathOffsets;
+	std::vector<std::uint32_t> pathLengths;
+
+	std::vector<std::uint64_t> lengths;
+	std::vector<std::uint64_t> offsets;
+	std::vector<std::uint32_t> crc32s;
+	std::vector<bool> removed;
+	std::size_t removedCount = 0;
+
+	SparseColumn<std::uint64_t> compressedLengths;
+	// VPK
+	SparseColumn<std::uint16_t> archiveIndices;
+	std::vector<std::byte> preloadPool;
+	SparseColumn<std::uint32_t> preloadOffsets;
+	SparseColumn<std::uint16_t> preloadLengths;
+	// ZIP/BSP
+	SparseColumn<std::uint16_t> compressionMethods;
+
+	// Open addressing with linear probing, each slot holds row + 1 (0 is empty)
+	std::vector<Row> indexSlots;
+	std::vector<std::uint32_t> pathHashes;
+	// Indexed row -> later rows with the same path, in the order they were added
+	std::unordered_map<Row, std::vector<Row>> duplicates;
+};
+
+} // namespace vpkedit::detail
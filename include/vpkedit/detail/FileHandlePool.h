@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vpkedit::detail {
+
+/// A file opened for positional reads, which don't move a shared file pointer
+/// so any number of threads can read through the same handle at once
+class FileHandle {
+public:
+	explicit FileHandle(const std::string& filepath);
+	FileHandle(const FileHandle& other) = delete;
+	FileHandle& operator=(const FileHandle& other) = delete;
+
+	~FileHandle();
+
+	/// False if the file could not be opened
+	explicit operator bool() const;
+
+	/// Fill the buffer starting at the given offset, returns false if the file ends first
+	[[nodiscard]] bool read(std::uint64_t offset, std::span<std::byte> buffer) const;
+
+#ifndef _WIN32
+	/// The underlying file descriptor, for handing reads to the kernel directly
+	[[nodiscard]] int getDescriptor() const;
+#endif
+
+#ifdef __linux__
+	/// Copy a range of the file to the current position of another file without it passing through user space.
+	/// Uses copy_file_range, then sendfile, then plain reads and writes if the kernel can't do either
+	[[nodiscard]] bool copyTo(std::uint64_t offset, std::uint64_t length, int outputDescriptor) const;
+#endif
+
+private:
+#ifdef _WIN32
+	void* handle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+/// Keeps a limited number of files open, closing the least recently used one when it runs out of room.
+/// Handles are shared, so one that gets evicted stays open until everyone reading from it is done
+class FileHandlePool {
+public:
+	explicit FileHandlePool(std::size_t maxOpenHandles_ = 16);
+	FileHandlePool(const FileHandlePool& other) = delete;
+	FileHandlePool& operator=(const FileHandlePool& other) = delete;
+	FileHandlePool(FileHandlePool&& other) noexcept;
+	FileHandlePool& operator=(FileHandlePool&& other) noexcept;
+
+	/// Get the handle for a key, opening the file at the given path if it's not in the pool.
+	/// The path function is only called on a miss. Returns nullptr if the file can't be opened
+	template<typename GetPath>
+	[[nodiscard]] std::shared_ptr<FileHandle> acquire(std::uint16_t key, GetPath&& getPath) {
+		if (auto handle = this->find(key)) {
+			return handle;
+		}
+		auto handle = std::make_shared<FileHandle>(getPath());
+		if (!*handle) {
+			return nullptr;
+		}
+		return this->insert(key, std::move(handle));
+	}
+
+	/// Close every handle, e.g. before the files are written to
+	void clear();
+
+private:
+	[[nodiscard]] std::shared_ptr<FileHandle> find(std::uint16_t key);
+
+	/// If another thread opened the same file in the meantime, its handle is returned instead
+	std::shared_ptr<FileHandle> insert(std::uint16_t key, std::shared_ptr<FileHandle> handle);
+
+	struct Slot {
+		std::uint16_t key;
+		std::shared_ptr<FileHandle> handle;
+		std::uint64_t lastUsed;
+	};
+
+	std::mutex mutex;
+	std::size_t maxOpenHandles;
+	std::vector<Slot> slots;
+	std::uint64_t clock = 0;
+};
+
+} // namespace vpkedit::detail
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
+#include <memory>
+#include <span>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -21,13 +24,17 @@ enum FileStreamOptions {
 template<typename T>
 concept PODType = std::is_trivial_v<T> && std::is_standard_layout_v<T>;
 
+/// Size of the buffer each FileStream reads and writes through, big enough that parsing a file
+/// field by field doesn't turn into a syscall every few bytes
+constexpr std::size_t FILESTREAM_BUFFER_SIZE = 64 * 1024;
+
 class FileStream {
 public:
 	explicit FileStream(const std::string& filepath, int options = FILESTREAM_OPT_READ);
 	FileStream(const FileStream& other) = delete;
 	FileStream& operator=(const FileStream& other) = delete;
 	FileStream(FileStream&& other) noexcept = default;
-	FileStream& operator=(FileStream&& other) noexcept = default;
+	FileStream& operator=(FileStream&& other) noexcept;
 
 	explicit operator bool() const;
 
@@ -71,6 +78,9 @@ public:
 
 	[[nodiscard]] std::vector<std::byte> readBytes(std::size_t length);
 
+	/// Fill the given buffer, returns false if the stream ran out of data
+	bool readBytes(std::span<std::byte> buffer);
+
 	[[nodiscard]] std::string readString();
 
 	[[nodiscard]] std::string readString(std::size_t n, bool stopOnNullTerminator = true);
@@ -87,8 +97,12 @@ public:
 
 	template<typename T, std::size_t N>
 	void read(std::array<T, N>& obj) {
-		for (int i = 0; i < N; i++) {
-			obj[i] = this->read<T>();
+		if constexpr (PODType<T>) {
+			this->streamFile.read(reinterpret_cast<char*>(obj.data()), sizeof(T) * N);
+		} else {
+			for (int i = 0; i < N; i++) {
+				obj[i] = this->read<T>();
+			}
 		}
 	}
 
@@ -98,19 +112,20 @@ public:
 		if (!n) {
 			return;
 		}
-		obj.reserve(n);
-		for (int i = 0; i < n; i++) {
-			obj.push_back(this->read<T>());
+		if constexpr (PODType<T>) {
+			obj.resize(n);
+			this->streamFile.read(reinterpret_cast<char*>(obj.data()), static_cast<std::streamsize>(sizeof(T) * n));
+		} else {
+			obj.reserve(n);
+			for (int i = 0; i < n; i++) {
+				obj.push_back(this->read<T>());
+			}
 		}
 	}
 
 	void read(std::string& obj) {
-		obj.clear();
-		char temp = this->read<char>();
-		while (temp != '\0') {
-			obj += temp;
-			temp = this->read<char>();
-		}
+		// Scans the buffered data for the terminator instead of going a character at a time
+		std::getline(this->streamFile, obj, '\0');
 	}
 
 	void read(std::string& obj, std::size_t n, bool stopOnNullTerminator = true) {
@@ -118,15 +133,14 @@ public:
 		if (!n) {
 			return;
 		}
-		obj.reserve(n);
-		for (int i = 0; i < n; i++) {
-			char temp = this->read<char>();
-			if (temp == '\0' && stopOnNullTerminator) {
-				// Read the required number of characters and exit
-				this->skipInput<char>(n - i - 1);
-				break;
+		// The full n characters are always consumed
+		obj.resize(n);
+		this->streamFile.read(obj.data(), static_cast<std::streamsize>(n));
+		obj.resize(static_cast<std::size_t>(this->streamFile.gcount()));
+		if (stopOnNullTerminator) {
+			if (auto terminator = obj.find('\0'); terminator != std::string::npos) {
+				obj.resize(terminator);
 			}
-			obj += temp;
 		}
 	}
 
@@ -143,6 +157,8 @@ public:
 
 	void writeBytes(const std::vector<std::byte>& buffer);
 
+	void writeBytes(std::span<const std::byte> buffer);
+
 	template<PODType T, std::size_t N>
 	void write(T(&obj)[N]) {
 		this->streamFile.write(reinterpret_cast<const char*>(&obj[0]), sizeof(T) * N);
@@ -150,15 +166,23 @@ public:
 
 	template<typename T, std::size_t N>
 	void write(const std::array<T, N>& obj) {
-		for (int i = 0; i < N; i++) {
-			this->write(obj[i]);
+		if constexpr (PODType<T>) {
+			this->streamFile.write(reinterpret_cast<const char*>(obj.data()), sizeof(T) * N);
+		} else {
+			for (int i = 0; i < N; i++) {
+				this->write(obj[i]);
+			}
 		}
 	}
 
 	template<typename T>
 	void write(const std::vector<T>& obj) {
-		for (T item : obj) {
-			this->write(item);
+		if constexpr (PODType<T>) {
+			this->streamFile.write(reinterpret_cast<const char*>(obj.data()), static_cast<std::streamsize>(sizeof(T) * obj.size()));
+		} else {
+			for (const T& item : obj) {
+				this->write(item);
+			}
 		}
 	}
 
@@ -170,18 +194,19 @@ public:
 	}
 
 	void write(const std::string& obj, std::size_t n) {
-		for (int i = 0; i < n; i++) {
-			if (i < obj.size()) {
-				this->write(obj[i]);
-			} else {
-				this->write('\0');
-			}
+		const auto length = std::min(obj.size(), n);
+		this->streamFile.write(obj.data(), static_cast<std::streamsize>(length));
+		for (auto i = length; i < n; i++) {
+			this->streamFile.put('\0');
 		}
 	}
 
 	void flush();
 
 protected:
+	/// Handed to streamFile when it opens, declared first so it outlives it
+	std::unique_ptr<char[]> streamBuffer;
+
 	std::fstream streamFile;
 };
 
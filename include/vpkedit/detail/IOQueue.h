@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "FileHandlePool.h"
+
+namespace vpkedit::detail {
+
+/// Runs many positional reads at once and hands them back as they finish, which is not necessarily the order
+/// they were queued in. On Linux the reads are submitted together through io_uring when the kernel allows it,
+/// everywhere else (or if io_uring is unavailable) each read runs synchronously when it's waited on
+class IOQueue {
+public:
+	struct Read {
+		std::shared_ptr<FileHandle> handle;
+		std::uint64_t offset;
+		std::span<std::byte> buffer;
+		/// Handed back when the read finishes to tell reads apart
+		std::size_t tag;
+	};
+
+	explicit IOQueue(std::uint32_t depth_ = 32, bool allowAsync = true);
+	IOQueue(const IOQueue& other) = delete;
+	IOQueue& operator=(const IOQueue& other) = delete;
+
+	~IOQueue();
+
+	/// True if queued reads actually run in parallel
+	[[nodiscard]] bool isAsync() const;
+
+	/// Queue a read, returns false if the queue already holds as many reads as its depth
+	bool push(Read read);
+
+	/// Number of reads queued that haven't finished yet
+	[[nodiscard]] std::size_t getPendingCount() const;
+
+	/// Wait until at least one read finishes, then call the function for every read that has.
+	/// Returns the number of reads that finished
+	std::size_t wait(const std::function<void(std::size_t tag, bool success)>& onComplete);
+
+private:
+	struct Ring;
+
+	std::uint32_t depth;
+	std::unique_ptr<Ring> ring;
+
+	/// Used when there is no ring
+	std::deque<Read> syncReads;
+};
+
+} // namespace vpkedit::detail
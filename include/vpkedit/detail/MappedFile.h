@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace vpkedit::detail {
+
+/// A read-only memory mapping of an entire file
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& filepath);
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	~MappedFile();
+
+	/// False if the file could not be opened or mapped
+	explicit operator bool() const;
+
+	[[nodiscard]] std::span<const std::byte> span() const;
+
+	[[nodiscard]] std::size_t size() const;
+
+private:
+	void unmap();
+
+	const std::byte* data = nullptr;
+	std::size_t length = 0;
+	bool mapped = false;
+};
+
+} // namespace vpkedit::detail
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -15,4 +16,8 @@ std::pair<std::string, std::string> splitFilenameAndParentDir(const std::string&
 
 std::vector<std::byte> readFileData(const std::string& filepath, std::size_t preloadBytesOffset = 0);
 
+/// Ask the filesystem to reserve space for data about to be written to the given range of a file, so it can be laid
+/// out in one piece. The file's size doesn't change. Does nothing where the platform can't do this
+void preallocateFile(const std::string& filepath, std::uint64_t offset, std::uint64_t length);
+
 } // namespace vpkedit::detail
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace vpkedit::detail {
+
+/// Runs one job and returns whether it succeeded. The buffer belongs to the thread running the job and is
+/// handed to every job that thread runs, so it only needs to be allocated once
+using ParallelJob = std::function<bool(std::size_t job, std::vector<std::byte>& buffer)>;
+
+/// Called once a job is done, with how many jobs are done so far. Calls are never made from two threads
+/// at once. Returning false cancels every job that hasn't started yet
+using ParallelJobCallback = std::function<bool(std::size_t job, bool success, std::size_t jobsDone)>;
+
+/// The requested number of threads, or one per hardware thread if that's 0, but never more than there are jobs
+[[nodiscard]] std::size_t getThreadCount(std::size_t threads, std::size_t jobCount = std::numeric_limits<std::size_t>::max());
+
+/// Run jobs 0 through jobCount - 1 on getThreadCount(threads, jobCount) threads, this one included.
+/// Jobs are started in order, so jobs sorted by where their data is stored read close to each other.
+/// Returns true if every job ran and succeeded
+bool runInParallel(std::size_t threads, std::size_t jobCount, const ParallelJob& job, const ParallelJobCallback& callback = nullptr);
+
+} // namespace vpkedit::detail
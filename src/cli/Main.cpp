@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include <argparse/argparse.hpp>
+#include <vpkedit/PackFile.h>
 #include <vpkedit/Version.h>
 #include <vpkedit/VPK.h>
 
@@ -31,6 +32,7 @@ void pack(const argparse::ArgumentParser& cli, const std::string& inputPath) {
 	auto preferredChunkSize = static_cast<std::uint32_t>(std::stoi(cli.get("-c")) * 1024 * 1024);
 	auto generateMD5Entries = cli.get<bool>("--gen-md5-entries");
 	auto allowUppercaseLettersInFilenames = cli.get<bool>("--allow-caps");
+	auto threads = static_cast<std::uint32_t>(std::stoi(cli.get("-t")));
 
 	auto vpk = VPK::createFromDirectoryProcedural(outputPath, inputPath, [saveToDir, &preloadExtensions](const std::string& fullEntryPath) {
 		int preloadBytes = 0;
@@ -47,10 +49,39 @@ void pack(const argparse::ArgumentParser& cli, const std::string& inputPath) {
 		.vpk_version = version,
 		.vpk_preferredChunkSize = preferredChunkSize,
 		.vpk_generateMD5Entries = generateMD5Entries,
+		.vpk_createFromDirectoryThreads = threads,
 	});
 	std::cout << "Successfully created VPK at \"" << vpk->getFilepath() << std::endl;
 }
 
+/// Extract the contents of a pack file into a directory
+void extract(const argparse::ArgumentParser& cli, const std::string& inputPath) {
+	auto packFile = PackFile::open(inputPath);
+	if (!packFile) {
+		throw std::runtime_error("Could not open the given file! Is it a supported type?");
+	}
+
+	auto outputPath = packFile->getTruncatedFilepath();
+	if (cli.is_used("-o")) {
+		outputPath = cli.get("-o");
+	}
+
+	std::size_t failedCount = 0;
+	bool success = packFile->extractAll(outputPath, {
+		.threads = static_cast<std::uint32_t>(std::stoi(cli.get("-t"))),
+	}, [&failedCount](const Entry& entry, bool entrySuccess, std::size_t, std::size_t) {
+		if (!entrySuccess) {
+			std::cerr << "Failed to extract \"" << entry.path << '"' << std::endl;
+			failedCount++;
+		}
+		return true;
+	});
+	if (!success) {
+		throw std::runtime_error("Failed to extract " + std::to_string(failedCount) + " file(s)!");
+	}
+	std::cout << "Successfully extracted " << packFile->getEntryCount() << " file(s) to \"" << outputPath << '"' << std::endl;
+}
+
 } // namespace
 
 int main(int argc, const char* const* argv) {
@@ -119,6 +150,12 @@ int main(int argc, const char* const* argv) {
 			 "all filenames will be converted to lowercase in the VPK.")
 	   .flag();
 
+	cli.add_argument("-t", "--threads")
+		.help("The number of threads to read and hash files on when packing, or to\n"
+			  "extract files on. If 0, uses one thread per CPU core.")
+		.default_value("0")
+		.nargs(1);
+
 	try {
 		cli.parse_args(argc, argv);
 
@@ -132,6 +169,8 @@ int main(int argc, const char* const* argv) {
 
 		if (std::filesystem::status(inputPath).type() == std::filesystem::file_type::directory) {
 			::pack(cli, inputPath);
+		} else {
+			::extract(cli, inputPath);
 		}
 	} catch (const std::exception& e) {
 		if (argc > 1) {
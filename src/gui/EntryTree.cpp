@@ -170,7 +170,7 @@ void EntryTree::loadPackFile(PackFile& packFile, QProgressBar* progressBar, cons
 
     // Set up progress bar
     progressBar->setMinimum(0);
-    progressBar->setMaximum(static_cast<int>(packFile.getBakedEntries().size()));
+    progressBar->setMaximum(static_cast<int>(packFile.getEntryCount(false)));
     progressBar->setValue(0);
 
     // Don't let the user touch anything
@@ -468,12 +468,14 @@ void EntryTree::removeEntryRecurse(QTreeWidgetItem* item) {
 
 void LoadPackFileWorker::run(EntryTree* tree, const PackFile& packFile) {
     int progress = 0;
-    for (const auto& [directory, entries] : packFile.getBakedEntries()) {
-        emit progressUpdated(++progress);
-        for (const auto& entry : entries) {
-            tree->addNestedEntryComponents(QString(directory.c_str()) + '/' + entry.getFilename().c_str());
+    packFile.runForAllEntries([this, tree, &progress](const std::string& directory, const Entry& entry) {
+        tree->addNestedEntryComponents(QString(directory.c_str()) + '/' + entry.getFilename().c_str());
+        // Updating the progress bar for every entry would flood the UI thread
+        if (++progress % 256 == 0) {
+            emit progressUpdated(progress);
         }
-    }
+    }, false);
+    emit progressUpdated(progress);
     tree->sortItems(0, Qt::AscendingOrder);
     emit taskFinished();
 }
@@ -686,20 +686,11 @@ void Window::renameDir(const QString& oldPath, const QString& newPath_) {
 	}
 
 	std::vector<QString> paths;
-	for (const auto& [directory, entries] : this->packFile->getBakedEntries()) {
+	this->packFile->runForAllEntries([&oldPath, &paths](const std::string& directory, const Entry& entry) {
 		if (QString(directory.c_str()).startsWith(oldPath)) {
-			for (const auto& entry : entries) {
-				paths.push_back(QString(directory.c_str()) + '/' + entry.getFilename().c_str());
-			}
-		}
-	}
-	for (const auto& [directory, entries] : this->packFile->getUnbakedEntries()) {
-		if (QString(directory.c_str()).startsWith(oldPath)) {
-			for (const auto& entry : entries) {
-				paths.push_back(QString(directory.c_str()) + '/' + entry.getFilename().c_str());
-			}
+			paths.push_back(QString(directory.c_str()) + '/' + entry.getFilename().c_str());
 		}
-	}
+	});
 
 	for (const auto& path : paths) {
 		// Get data
@@ -836,16 +827,11 @@ void Window::extractFilesIf(const QString& saveDir, const std::function<bool(con
 
     // Get progress bar maximum
     int progressBarMax = 0;
-    for (const auto& [directory, entries] : this->packFile->getBakedEntries()) {
+    this->packFile->runForAllEntries([&predicate, &progressBarMax](const std::string& directory, const Entry&) {
         if (predicate(QString(directory.c_str()))) {
-	        progressBarMax += static_cast<int>(entries.size());
+            progressBarMax++;
         }
-    }
-	for (const auto& [directory, entries] : this->packFile->getUnbakedEntries()) {
-		if (predicate(QString(directory.c_str()))) {
-			progressBarMax += static_cast<int>(entries.size());
-		}
-	}
+    });
 
     this->statusProgressBar->setRange(0, progressBarMax);
     this->statusProgressBar->setValue(0);
@@ -862,7 +848,7 @@ void Window::extractFilesIf(const QString& saveDir, const std::function<bool(con
     QObject::connect(worker, &ExtractPackFileWorker::progressUpdated, this, [this](int value) {
         this->statusProgressBar->setValue(value);
     });
-    QObject::connect(worker, &ExtractPackFileWorker::taskFinished, this, [this] {
+    QObject::connect(worker, &ExtractPackFileWorker::taskFinished, this, [this](bool success) {
         // Kill thread
         this->extractPackFileWorkerThread->quit();
         this->extractPackFileWorkerThread->wait();
@@ -872,6 +858,10 @@ void Window::extractFilesIf(const QString& saveDir, const std::function<bool(con
         this->freezeActions(false);
 
         this->resetStatusBar();
+
+        if (!success) {
+            QMessageBox::critical(this, tr("Error"), tr("Failed to extract some files. Please ensure that a game or another application is not using the file, and that the output folder can be written to."));
+        }
     });
     this->extractPackFileWorkerThread->start();
 }
@@ -1103,21 +1093,9 @@ void Window::rebuildOpenRecentMenu(const QStringList& paths) {
 }
 
 void Window::writeEntryToFile(const QString& path, const Entry& entry) {
-    auto data = this->packFile->readEntry(entry);
-    if (!data) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to read data for \"%1\". Please ensure that a game or another application is not using the file.").arg(entry.path.c_str()));
-        return;
+    if (!this->packFile->extractEntry(entry, path.toStdString())) {
+        QMessageBox::critical(this, tr("Error"), tr("Failed to write \"%1\" to \"%2\". Please ensure that a game or another application is not using the file.").arg(QString(entry.path.c_str()), path));
     }
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to write to file at \"%1\".").arg(path));
-        return;
-    }
-    auto bytesWritten = file.write(reinterpret_cast<const char*>(data->data()), static_cast<std::streamsize>(entry.length));
-    if (bytesWritten != entry.length) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to write to file at \"%1\".").arg(path));
-    }
-    file.close();
 }
 
 void Window::resetStatusBar() {
@@ -1145,88 +1123,11 @@ void SavePackFileWorker::run(Window* window, const QString& savePath) {
 }
 
 void ExtractPackFileWorker::run(Window* window, const QString& saveDir, const std::function<bool(const QString&)>& predicate) {
-    int currentEntry = 0;
-    for (const auto& [directory, entries] : window->packFile->getBakedEntries()) {
-        QString dir(directory.c_str());
-        if (!predicate(dir)) {
-            continue;
-        }
-
-#ifdef _WIN32
-		// Remove bad characters from the filepath
-		dir.replace('<', "_LT_");
-		dir.replace('>', "_GT_");
-		dir.replace(':', "_COLON_");
-		dir.replace('"', "_QUOT_");
-		dir.replace('|', "_BAR_");
-		dir.replace('?', "_QMARK_");
-		dir.replace('*', "_AST_");
-#endif
-
-        QDir qDir;
-        if (!qDir.mkpath(saveDir + QDir::separator() + dir)) {
-            QMessageBox::critical(window, tr("Error"), tr("Failed to create directory."));
-            return;
-        }
-
-        for (const auto& entry : entries) {
-			std::string filename{entry.getFilename()};
-#ifdef _WIN32
-	        {
-				std::filesystem::path path{filename};
-		        auto extension = path.extension().string();
-		        QString stem = path.stem().string().c_str();
-				stem = stem.toUpper();
-
-		        // Replace bad filenames
-		        if (stem == "CON") {
-			        filename = "_CON_" + extension;
-		        } else if (stem == "PRN") {
-			        filename = "_PRN_" + extension;
-		        } else if (stem == "AUX") {
-			        filename = "_AUX_" + extension;
-		        } else if (stem == "NUL") {
-			        filename = "_NUL_" + extension;
-		        } else if (stem.startsWith("COM") && stem.length() == 4 && stem[3].isDigit() && stem[3] != '0') {
-			        filename = "_COM";
-					filename += stem[3].toLatin1();
-					filename += '_';
-					filename += extension;
-		        } else if (stem.startsWith("LPT") && stem.length() == 4 && stem[3].isDigit() && stem[3] != '0') {
-			        filename = "_LPT";
-					filename += stem[3].toLatin1();
-					filename += '_';
-					filename += extension;
-		        }
-
-		        // Files cannot end with a period - weird
-		        if (extension == ".") {
-			        filename.pop_back();
-		        }
-	        }
-#endif
-            auto filePath = saveDir + QDir::separator() + dir + QDir::separator() + filename.c_str();
-            window->writeEntryToFile(filePath, entry);
-            emit progressUpdated(++currentEntry);
-        }
-    }
-	for (const auto& [directory, entries] : window->packFile->getUnbakedEntries()) {
-		QString dir(directory.c_str());
-		if (!predicate(dir)) {
-			continue;
-		}
-
-		QDir qDir;
-		if (!qDir.mkpath(saveDir + QDir::separator() + dir)) {
-			QMessageBox::critical(window, tr("Error"), tr("Failed to create directory."));
-			return;
-		}
-
-		for (const auto& entry : entries) {
-			auto filePath = saveDir + QDir::separator() + dir + QDir::separator() + entry.getFilename().c_str();
-			window->writeEntryToFile(filePath, entry);
-			emit progressUpdated(++currentEntry);
-		}
-	}
-    emit taskFinished();
+	bool success = window->packFile->extractIf(saveDir.toStdString(), [&predicate](const Entry& entry) {
+		return predicate(QString(entry.getParentPath().c_str()));
+	}, {}, [this](const Entry&, bool, std::size_t entriesDone, std::size_t) {
+		emit progressUpdated(static_cast<int>(entriesDone));
+		return true;
+	});
+	emit taskFinished(success);
 }
@@ -184,5 +184,5 @@ public:
 
 signals:
     void progressUpdated(int value);
-    void taskFinished();
+    void taskFinished(bool success);
 };
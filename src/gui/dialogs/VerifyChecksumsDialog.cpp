@@ -1,7 +1,14 @@
 #include "VerifyChecksumsDialog.h"
 
+#include <atomic>
+#include <chrono>
+#include <future>
+
+#include <QApplication>
+#include <QProgressDialog>
 #include <vpkedit/PackFile.h>
 
+using namespace std::literals::chrono_literals;
 using namespace vpkedit;
 
 VerifyChecksumsDialog::VerifyChecksumsDialog(PackFile& packFile, QWidget* parent)
@@ -9,15 +16,53 @@ VerifyChecksumsDialog::VerifyChecksumsDialog(PackFile& packFile, QWidget* parent
 	this->setModal(true);
 	this->setWindowTitle(tr("Verify Checksums"));
 
+	// Checking every entry can take a while, do it off the UI thread and keep the progress dialog responsive
+	QProgressDialog progress(tr("Verifying checksums..."), tr("Cancel"), 0, 0, parent);
+	progress.setWindowTitle(tr("Verify Checksums"));
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(500);
+
+	std::atomic<std::size_t> entriesDone = 0;
+	std::atomic<std::size_t> entriesTotal = 0;
+	std::atomic<bool> cancelled = false;
+	auto task = std::async(std::launch::async, [&] {
+		bool fileChecksumValid = packFile.verifyFileChecksum();
+		auto badEntries = packFile.verifyEntryChecksums({}, [&](const Entry&, bool, std::size_t done, std::size_t total) {
+			entriesDone = done;
+			entriesTotal = total;
+			return !cancelled;
+		});
+		return std::make_pair(fileChecksumValid, std::move(badEntries));
+	});
+	while (task.wait_for(50ms) != std::future_status::ready) {
+		if (progress.wasCanceled()) {
+			cancelled = true;
+		}
+		if (auto total = entriesTotal.load()) {
+			progress.setMaximum(static_cast<int>(total));
+			progress.setValue(static_cast<int>(entriesDone.load()));
+		}
+		QApplication::processEvents();
+	}
+	auto [fileChecksumValid, entries] = task.get();
+	progress.reset();
+
 	QString text;
-	if (packFile.verifyFileChecksum()) {
+	if (fileChecksumValid) {
 		text = u8"✅ " + tr("Overall file checksum matches the expected value.");
 	} else {
 		text = u8"❌ " + tr("Overall file checksum does not match the expected value!");
 	}
 	text += "\n\n";
 
-	if (auto entries = packFile.verifyEntryChecksums(); entries.empty()) {
+	if (cancelled) {
+		text += u8"⚠️ " + tr("Verification was cancelled, not every file was checked.");
+		text += "\n\n";
+	}
+
+	if (entries.empty() && cancelled) {
+		text += u8"✅ " + tr("The file checksums that were checked match their expected values.");
+	} else if (entries.empty()) {
 		text += u8"✅ " + tr("All file checksums match their expected values.");
 	} else {
 		text += u8"❌ " + tr("Some file checksums do not match their expected values!\nSee below for more information.");
@@ -69,46 +69,9 @@ std::unique_ptr<PackFile> BSP::open(const std::string& path, PackFileOptions opt
 		writer.writeBytes(binData);
 	}
 
-	if (!bsp->openZIP(BSP::TEMP_ZIP_PATH)) {
+	if (!bsp->openZIP(BSP::TEMP_ZIP_PATH) || !bsp->loadEntries(callback)) {
 		return nullptr;
 	}
-
-	for (auto code = mz_zip_goto_first_entry(bsp->zipHandle); code == MZ_OK; code = mz_zip_goto_next_entry(bsp->zipHandle)) {
-		mz_zip_file* fileInfo = nullptr;
-		if (mz_zip_entry_get_info(bsp->zipHandle, &fileInfo)) {
-			return nullptr;
-		}
-		if (mz_zip_entry_is_dir(bsp->zipHandle) == MZ_OK) {
-			continue;
-		}
-
-		Entry entry = createNewEntry();
-		entry.path = fileInfo->filename;
-		::normalizeSlashes(entry.path);
-		if (!options.allowUppercaseLettersInFilenames) {
-			::toLowerCase(entry.path);
-		}
-
-		entry.length = fileInfo->uncompressed_size;
-		entry.compressedLength = fileInfo->compressed_size;
-		entry.crc32 = fileInfo->crc;
-		entry.zip_compressionMethod = fileInfo->compression_method;
-
-		auto parentDir = std::filesystem::path(entry.path).parent_path().string();
-		::normalizeSlashes(parentDir);
-		if (!options.allowUppercaseLettersInFilenames) {
-			::toLowerCase(parentDir);
-		}
-		if (!bsp->entries.contains(parentDir)) {
-			bsp->entries[parentDir] = {};
-		}
-		bsp->entries[parentDir].push_back(entry);
-
-		if (callback) {
-			callback(parentDir, entry);
-		}
-	}
-
 	return packFile;
 }
 
@@ -125,6 +88,7 @@ bool BSP::bake(const std::string& outputDir_, const Callback& callback) {
 
 	// Close the ZIP
 	this->closeZIP();
+	this->closeArchives();
 
 	// Write the pakfile lump
 	{
@@ -153,7 +117,15 @@ bool BSP::bake(const std::string& outputDir_, const Callback& callback) {
 		return false;
 	}
 	PackFile::setFullFilePath(outputDir);
-	return true;
+
+	// Entry offsets have all changed
+	this->entries.clear();
+	return this->loadEntries(nullptr);
+}
+
+std::uint64_t BSP::getZIPOffset() const {
+	// Entries are read out of the paklump inside the BSP itself
+	return this->header.lumps[BSP_LUMP_PAKFILE_INDEX].offset;
 }
 
 void BSP::moveLumpToWritableSpace(int lumpToMove, int newSize) {
@@ -1,6 +1,8 @@
 #include <vpkedit/Entry.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <utility>
 
 using namespace vpkedit;
 
@@ -23,3 +25,73 @@ std::string Entry::getExtension() const {
 	}
 	return ext;
 }
+
+EntryView::EntryView(std::span<const std::byte> view_)
+		: view(view_)
+		, mapped(true) {}
+
+EntryView::EntryView(std::vector<std::byte>&& data_)
+		: owned(std::move(data_)) {}
+
+bool EntryView::isMapped() const {
+	return this->mapped;
+}
+
+std::span<const std::byte> EntryView::span() const {
+	return this->mapped ? this->view : std::span<const std::byte>{this->owned};
+}
+
+const std::byte* EntryView::data() const {
+	return this->span().data();
+}
+
+std::size_t EntryView::size() const {
+	return this->span().size();
+}
+
+bool EntryView::empty() const {
+	return this->span().empty();
+}
+
+const std::byte* EntryView::begin() const {
+	return this->data();
+}
+
+const std::byte* EntryView::end() const {
+	return this->data() + this->size();
+}
+
+EntryView::operator std::span<const std::byte>() const {
+	return this->span();
+}
+
+EntryReader::EntryReader(std::uint64_t length_)
+		: length(length_) {}
+
+std::optional<std::size_t> EntryReader::read(std::span<std::byte> buffer) {
+	buffer = buffer.first(static_cast<std::size_t>(std::min<std::uint64_t>(buffer.size(), this->length - this->position)));
+	if (buffer.empty()) {
+		return 0;
+	}
+	if (!this->readInternal(buffer)) {
+		return std::nullopt;
+	}
+	this->position += buffer.size();
+	return buffer.size();
+}
+
+bool EntryReader::seek(std::uint64_t position_) {
+	if (position_ > this->length) {
+		return false;
+	}
+	this->position = position_;
+	return true;
+}
+
+std::uint64_t EntryReader::tell() const {
+	return this->position;
+}
+
+std::uint64_t EntryReader::size() const {
+	return this->length;
+}
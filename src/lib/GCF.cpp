@@ -2,7 +2,11 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <limits>
+#include <numeric>
+#include <string_view>
 #include <tuple>
+#include <utility>
 
 #include <vpkedit/detail/Adler32.h>
 #include <vpkedit/detail/CRC32.h>
@@ -12,6 +16,13 @@
 using namespace vpkedit;
 using namespace vpkedit::detail;
 
+namespace {
+
+/// Each entry checksum covers this much of the entry's data
+constexpr std::size_t GCF_CHECKSUM_BLOCK_SIZE = 0x8000;
+
+} // namespace
+
 GCF::GCF(const std::string& fullFilePath_, PackFileOptions options_)
 		: PackFileReadOnly(fullFilePath_, options_) {
 	this->type = PackFileType::GCF;
@@ -71,10 +82,7 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 	}
 
 	// block headers!!!!!!
-	for (int i = 0; i < gcf->header.blockcount; i++) {
-		Block& block = gcf->blockdata.emplace_back();
-		reader.read(block);
-	}
+	reader.read(gcf->blockdata, gcf->header.blockcount);
 
 	// Fragmentation Map header
 	// not worth keeping around after verifying stuff so no struct def
@@ -99,9 +107,7 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 
 	// Fragmentation Map (list of dwords)
 
-	for (int i = 0; i < blkcount; i++) {
-		gcf->fragmap.push_back(reader.read<std::uint32_t>());
-	}
+	reader.read(gcf->fragmap, blkcount);
 
 	// Directory stuff starts here
 
@@ -109,50 +115,90 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 	std::uint64_t temp = reader.tellInput();
 	reader.read(gcf->dirheader);
 
-	std::uint64_t diroffset = reader.tellInput() + (gcf->dirheader.itemcount * 28);
-	std::uint64_t currentoffset;
-
-	std::vector<DirectoryEntry2> direntries{};
-
-	for (int i = 0; i < gcf->dirheader.itemcount; i++) {
-		DirectoryEntry2& entry = direntries.emplace_back();
-		reader.read(entry.entry_real);
-		currentoffset = reader.tellInput();
-		reader.seekInput(diroffset + entry.entry_real.nameoffset);
-		reader.read(entry.filename);
-		if (entry.entry_real.dirtype != 0) { // if not directory
-			std::string dirname;
-			DirectoryEntry2 current_filename_entry = entry;
-			while (current_filename_entry.entry_real.parentindex != 0xffffffff) {
-				current_filename_entry = direntries[current_filename_entry.entry_real.parentindex];
-				dirname.insert(0, "/");
-				dirname.insert(0, current_filename_entry.filename);
-			}
-			Entry gcfEntry = createNewEntry();
-			::normalizeSlashes(dirname);
-			if (!options.allowUppercaseLettersInFilenames) {
-				::toLowerCase(dirname);
-				::toLowerCase(entry.filename);
-			}
-			if (!gcf->entries.contains(dirname)) {
-				//printf("dirname creation: %s\n", dirname.c_str());
-				gcf->entries[dirname] = {};
+	// The directory entries are followed by the name table, read both in one go
+	// The rest of the directory isn't needed, but the name table's size isn't always filled in, so it's read anyway
+	if (sizeof(DirectoryHeader) + static_cast<std::uint64_t>(gcf->dirheader.itemcount) * sizeof(DirectoryEntry) > gcf->dirheader.dirsize) {
+		return nullptr;
+	}
+	std::vector<DirectoryEntry> direntries(gcf->dirheader.itemcount);
+	std::vector<char> names(gcf->dirheader.dirsize - sizeof(DirectoryHeader) - direntries.size() * sizeof(DirectoryEntry));
+	if (!reader.readBytes(std::as_writable_bytes(std::span{direntries})) || !reader.readBytes(std::as_writable_bytes(std::span{names}))) {
+		return nullptr;
+	}
+	const auto getName = [&names](const DirectoryEntry& entry) -> std::string_view {
+		if (entry.nameoffset >= names.size()) {
+			return "";
+		}
+		std::string_view name{names.data() + entry.nameoffset, names.size() - entry.nameoffset};
+		return name.substr(0, name.find('\0'));
+	};
+
+	// Every directory's path (all of its parents' names and its own, each followed by a slash) is built once,
+	// parents first, so files only have to append their name to it
+	static constexpr std::uint32_t NO_PARENT = 0xffffffff;
+	std::vector<std::string> dirpaths(gcf->dirheader.itemcount);
+	std::vector<bool> dirpathResolved(gcf->dirheader.itemcount);
+	std::vector<std::uint32_t> unresolved;
+	const auto resolveDirPath = [&](std::uint32_t index) -> const std::string& {
+		for (auto current = index; current < direntries.size() && !dirpathResolved[current]; current = direntries[current].parentindex) {
+			// Mark it now, a broken file could make a directory its own ancestor
+			dirpathResolved[current] = true;
+			unresolved.push_back(current);
+		}
+		while (!unresolved.empty()) {
+			auto current = unresolved.back();
+			unresolved.pop_back();
+			if (auto parent = direntries[current].parentindex; parent < direntries.size()) {
+				dirpaths[current] = dirpaths[parent];
 			}
-			gcfEntry.length = entry.entry_real.itemsize;
-			gcfEntry.path = dirname;
-			gcfEntry.path += dirname.empty() ? "" : "/";
-			gcfEntry.path += entry.filename;
-			gcfEntry.crc32 = entry.entry_real.fileid; // INDEX INTO THE CHECKSUM MAP VECTOR NOT CRC32!!!
-			gcfEntry.offset = i; // THIS IS THE STRUCT INDEX NOT SOME OFFSET!!!
-			//printf("%s\n", vpkedit_entry.path.c_str());
-			gcf->entries[dirname].push_back(gcfEntry);
-			//printf("dir %s file %s\n", dirname.c_str(), entry.filename.c_str());
-
-			if (callback) {
-				callback(dirname, gcfEntry);
+			dirpaths[current] += getName(direntries[current]);
+			dirpaths[current] += '/';
+		}
+		return dirpaths[index];
+	};
+
+	// The same directory path after it's been normalized, only filled for directories that hold files
+	std::vector<std::string> entryDirs(gcf->dirheader.itemcount);
+	std::vector<bool> entryDirResolved(gcf->dirheader.itemcount);
+
+	for (std::uint32_t i = 0; i < gcf->dirheader.itemcount; i++) {
+		const auto& entry = direntries[i];
+		if (entry.dirtype == 0) { // if directory
+			continue;
+		}
+
+		std::string dirname;
+		if (auto parent = entry.parentindex; parent != NO_PARENT && parent < direntries.size()) {
+			if (!entryDirResolved[parent]) {
+				entryDirs[parent] = resolveDirPath(parent);
+				::normalizeSlashes(entryDirs[parent]);
+				if (!options.allowUppercaseLettersInFilenames) {
+					::toLowerCase(entryDirs[parent]);
+				}
+				entryDirResolved[parent] = true;
 			}
+			dirname = entryDirs[parent];
+		}
+
+		std::string filename{getName(entry)};
+		if (!options.allowUppercaseLettersInFilenames) {
+			::toLowerCase(filename);
+		}
+
+		Entry gcfEntry = createNewEntry();
+		gcfEntry.length = entry.itemsize;
+		gcfEntry.path = dirname;
+		gcfEntry.path += dirname.empty() ? "" : "/";
+		gcfEntry.path += filename;
+		gcfEntry.crc32 = entry.fileid; // INDEX INTO THE CHECKSUM MAP VECTOR NOT CRC32!!!
+		gcfEntry.offset = i; // THIS IS THE STRUCT INDEX NOT SOME OFFSET!!!
+		//printf("%s\n", vpkedit_entry.path.c_str());
+		gcf->insertBakedEntry(gcfEntry);
+		//printf("dir %s file %s\n", dirname.c_str(), filename.c_str());
+
+		if (callback) {
+			callback(dirname, gcfEntry);
 		}
-		reader.seekInput(currentoffset);
 	}
 
 	// Directory Map
@@ -164,9 +210,29 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 	reader.skipInput<DirectoryMapHeader>();
 
 	// Directory Map entries
-	for (int i = 0; i < gcf->dirheader.itemcount; i++) {
-		DirectoryMapEntry& entry = gcf->dirmap_entries.emplace_back();
-		reader.read(entry);
+	reader.read(gcf->dirmap_entries, gcf->dirheader.itemcount);
+
+	// Group the blocks by the directory entry they belong to, so reading an entry doesn't have to look at every block
+	gcf->entryBlockStarts.assign(gcf->dirheader.itemcount + 1, 0);
+	for (const auto& block : gcf->blockdata) {
+		if (block.dir_index < gcf->dirheader.itemcount) {
+			gcf->entryBlockStarts[block.dir_index + 1]++;
+		}
+	}
+	std::partial_sum(gcf->entryBlockStarts.begin(), gcf->entryBlockStarts.end(), gcf->entryBlockStarts.begin());
+	gcf->entryBlocks.resize(gcf->entryBlockStarts.back());
+	{
+		auto nextSlot = gcf->entryBlockStarts;
+		for (std::uint32_t i = 0; i < gcf->blockdata.size(); i++) {
+			if (auto dirIndex = gcf->blockdata[i].dir_index; dirIndex < gcf->dirheader.itemcount) {
+				gcf->entryBlocks[nextSlot[dirIndex]++] = i;
+			}
+		}
+	}
+	for (std::uint32_t i = 0; i < gcf->dirheader.itemcount; i++) {
+		std::stable_sort(gcf->entryBlocks.begin() + gcf->entryBlockStarts[i], gcf->entryBlocks.begin() + gcf->entryBlockStarts[i + 1], [gcf](std::uint32_t lhs, std::uint32_t rhs) {
+			return gcf->blockdata[lhs].file_data_offset < gcf->blockdata[rhs].file_data_offset;
+		});
 	}
 
 	// Checksum header
@@ -186,15 +252,8 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 
 	//printf("%lu %lu\n", chksummapheader.checksum_count, chksummapheader.item_count);
 
-	for (int i = 0; i < chksummapheader.item_count; i++) {
-		auto& cur_entry = gcf->chksum_map.emplace_back();
-		reader.read(cur_entry);
-	}
-
-	for (int i = 0; i < chksummapheader.checksum_count; i++) {
-		auto& currentChecksum = gcf->checksums.emplace_back();
-		reader.read(currentChecksum);
-	}
+	reader.read(gcf->chksum_map, chksummapheader.item_count);
+	reader.read(gcf->checksums, chksummapheader.checksum_count);
 	//printf("current pos: %llu, block header: %llu should be: %llu", reader.tellInput(), reader.tellInput() + 0x80, checksums_start + checksumsize);
 	// TODO: check the checksum RSA signature... later.. if ever...
 
@@ -205,100 +264,193 @@ std::unique_ptr<PackFile> GCF::open(const std::string& path, PackFileOptions opt
 }
 
 std::optional<std::vector<std::byte>> GCF::readEntry(const Entry& entry) const {
-	if (entry.unbaked) {
-		// Get the stored data
-		for (const auto& [unbakedEntryDir, unbakedEntryList] : this->unbakedEntries) {
-			for (const Entry& unbakedEntry : unbakedEntryList) {
-				if (unbakedEntry.path == entry.path) {
-					std::vector<std::byte> unbakedData;
-					if (isEntryUnbakedUsingByteBuffer(unbakedEntry)) {
-						unbakedData = std::get<std::vector<std::byte>>(getEntryUnbakedData(unbakedEntry));
-					}
-					else {
-						unbakedData = ::readFileData(std::get<std::string>(getEntryUnbakedData(unbakedEntry)));
-					}
-					return unbakedData;
-				}
-			}
-		}
+	std::vector<std::byte> filedata(entry.length);
+	if (!this->readEntryRangeInternal(entry, 0, filedata)) {
 		return std::nullopt;
 	}
+	return filedata;
+}
 
-	std::vector<std::byte> filedata;
-	if (entry.length == 0) {
+bool GCF::readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	if (entry.unbaked) {
+		return this->readUnbakedEntryInto(entry, offset, buffer);
+	}
+	if (buffer.empty()) {
 		// don't bother
-		return filedata;
+		return true;
 	}
+	// The buffer is big enough for the whole range, so it's only filled once
+	return this->readEntryChunks(entry, offset, buffer.size(), buffer, [](std::span<const std::byte>) {
+		return true;
+	});
+}
 
-	std::uint32_t dir_index = entry.offset;
-	//printf(" extracting file: %s\n", entry.path.c_str());
-
-	std::vector<Block> toread;
-	for (const auto& v : this->blockdata) {
-		if (v.dir_index == dir_index) {
-			toread.push_back(v);
-		}
+std::optional<EntryView> GCF::readEntryView(const Entry& entry) const {
+	if (entry.unbaked || entry.length == 0) {
+		return PackFile::readEntryView(entry);
 	}
 
-	std::sort(toread.begin(), toread.end(), [](Block lhs, Block rhs) {
-		return (lhs.file_data_offset < rhs.file_data_offset);
+	// Data blocks can be scattered across the file, only hand out a view if they happen to be in order
+	std::optional<std::uint32_t> firstindex;
+	std::uint32_t nextindex = 0;
+	std::uint64_t remaining = entry.length;
+	for (auto blockIndex : this->getEntryBlocks(entry)) {
+		std::uint32_t currindex = this->blockdata[blockIndex].first_data_block_index;
+		while (currindex < this->fragmap.size() && remaining > 0) {
+			if (!firstindex) {
+				firstindex = currindex;
+			} else if (currindex != nextindex) {
+				return PackFile::readEntryView(entry);
+			}
+			nextindex = currindex + 1;
+			remaining -= std::min(remaining, static_cast<std::uint64_t>(0x2000));
+			currindex = this->fragmap[currindex];
 		}
-	);
+	}
+	if (!firstindex || remaining > 0) {
+		return PackFile::readEntryView(entry);
+	}
 
-	if (toread.empty()) {
-		//printf("could not find any directory index for %lu", entry.vpk_offset);
+	const auto* archive = this->getMappedArchive(0);
+	if (!archive) {
 		return std::nullopt;
 	}
-
-	FileStream stream{this->fullFilePath};
-	if (!stream) {
-		//printf("!stream\n");
+	std::uint64_t offset = static_cast<std::uint64_t>(this->datablockheader.firstblockoffset) + (static_cast<std::uint64_t>(0x2000) * static_cast<std::uint64_t>(*firstindex));
+	if (offset + entry.length > archive->size()) {
 		return std::nullopt;
 	}
+	return EntryView{archive->span().subspan(offset, entry.length)};
+}
 
-	std::uint64_t remaining = entry.length;
-
-	for (const auto& block : toread) {
-		std::uint32_t currindex = block.first_data_block_index;
-		while (currindex <= this->blockheader.count) {
-			std::uint64_t curfilepos = static_cast<std::uint64_t>(this->datablockheader.firstblockoffset) + (static_cast<std::uint64_t>(0x2000) * static_cast<std::uint64_t>(currindex));
-			stream.seekInput(curfilepos);
-			//printf("off %lli block %lu toread %lli should be %llu\n", stream.tellInput(), currindex, remaining, curfilepos);
-			std::uint32_t toreadAmt = std::min(remaining, static_cast<std::uint64_t>(0x2000));
-			auto streamvec = stream.readBytes(toreadAmt);
-			filedata.insert(filedata.end(), streamvec.begin(), streamvec.end());
-			remaining -= toreadAmt;
-			currindex = this->fragmap[currindex];
-			//printf("curridx now: %lu\n", currindex);
-		}
+std::span<const std::uint32_t> GCF::getEntryBlocks(const Entry& entry) const {
+	std::uint64_t dir_index = entry.offset;
+	if (dir_index + 1 >= this->entryBlockStarts.size()) {
+		return {};
 	}
-
-	return filedata;
+	return std::span{this->entryBlocks}.subspan(this->entryBlockStarts[dir_index], this->entryBlockStarts[dir_index + 1] - this->entryBlockStarts[dir_index]);
 }
 
-std::vector<std::string> GCF::verifyEntryChecksums() const {
-	std::vector<std::string> bad;
-	for (const auto& entryList : this->entries) {
-		for (const auto& entry : entryList.second) {
-			auto bytes = this->readEntry(entry);
-			if (!bytes || bytes->empty()) {
+bool GCF::readEntryChunks(const Entry& entry, std::uint64_t offset, std::uint64_t length, std::span<std::byte> buffer, const ChunkCallback& callback) const {
+	auto toread = this->getEntryBlocks(entry);
+	if (toread.empty() || buffer.empty()) {
+		return false;
+	}
+
+	// Skip over whole blocks until the range starts, then copy the data into its place in the buffer.
+	// Data blocks that follow each other in the file are read together
+	std::uint64_t skip = offset;
+	std::uint64_t remaining = length;
+	std::uint64_t filled = 0;
+	std::uint64_t runfilepos = 0;
+	std::uint64_t runlength = 0;
+	const auto readRun = [this, &buffer, &filled, &runlength, &runfilepos] {
+		if (runlength > 0) {
+			if (!this->readArchiveInto(0, runfilepos, buffer.subspan(filled, runlength))) {
+				return false;
+			}
+			filled += runlength;
+			runlength = 0;
+		}
+		return true;
+	};
+	for (auto blockIndex : toread) {
+		std::uint32_t currindex = this->blockdata[blockIndex].first_data_block_index;
+		while (currindex < this->fragmap.size() && remaining > 0) {
+			if (skip >= 0x2000) {
+				skip -= 0x2000;
+				currindex = this->fragmap[currindex];
 				continue;
 			}
-			std::size_t tocheck = bytes->size();
-			std::uint32_t idx = entry.crc32;
-			std::uint32_t count = this->chksum_map[idx].count;
-			std::uint32_t checksumstart = this->chksum_map[idx].firstindex;
-			for (int i = 0; i < count; i++) {
-				std::uint32_t csum = this->checksums[checksumstart + i];
-				std::size_t toread = std::min(static_cast<std::size_t>(0x8000), tocheck);
-				const auto* data = bytes->data() + (i * 0x8000);
-				std::uint32_t checksum = ::computeCRC32(data, toread) ^ ::computeAdler32(data, toread);
-				if (checksum != csum) {
-					bad.push_back(entry.path);
+			std::uint64_t curfilepos = static_cast<std::uint64_t>(this->datablockheader.firstblockoffset) + (static_cast<std::uint64_t>(0x2000) * static_cast<std::uint64_t>(currindex)) + skip;
+			std::uint64_t toreadAmt = std::min({remaining, buffer.size() - filled - runlength, static_cast<std::uint64_t>(0x2000) - skip});
+			if (runlength > 0 && curfilepos == runfilepos + runlength) {
+				runlength += toreadAmt;
+			} else {
+				if (!readRun()) {
+					return false;
+				}
+				runfilepos = curfilepos;
+				runlength = toreadAmt;
+			}
+			remaining -= toreadAmt;
+			// If the buffer filled up partway through this block, the rest of it is picked up next time around
+			skip += toreadAmt;
+
+			if (filled + runlength == buffer.size()) {
+				if (!readRun()) {
+					return false;
+				}
+				filled = 0;
+				if (!callback(buffer)) {
+					return true;
 				}
-				tocheck -= toread;
 			}
 		}
+		if (remaining == 0) {
+			break;
+		}
+	}
+	if (!readRun()) {
+		return false;
+	}
+	if (filled > 0) {
+		callback(buffer.first(filled));
+	}
+	return remaining == 0;
+}
+
+std::vector<std::string> GCF::verifyEntryChecksums(VerifyOptions options, const VerifyCallback& callback) const {
+	std::vector<Entry> entries;
+	this->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+		entries.push_back(entry);
+	}, false);
+
+	// Check the entries in roughly the order their data is stored, so the threads read close to each other
+	const auto firstDataBlock = [this](const Entry& entry) {
+		auto blocks = this->getEntryBlocks(entry);
+		return blocks.empty() ? std::numeric_limits<std::uint32_t>::max() : this->blockdata[blocks.front()].first_data_block_index;
+	};
+	std::vector<std::pair<std::uint32_t, std::size_t>> order;
+	order.reserve(entries.size());
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		order.emplace_back(firstDataBlock(entries[i]), i);
+	}
+	std::sort(order.begin(), order.end());
+	std::vector<Entry> sortedEntries;
+	sortedEntries.reserve(entries.size());
+	for (auto [block, i] : order) {
+		sortedEntries.push_back(std::move(entries[i]));
 	}
-	return bad;
+
+	return this->verifyEntriesInParallel(sortedEntries, [this, &options](const Entry& entry, std::vector<std::byte>& buffer) {
+		if (entry.length == 0) {
+			return true;
+		}
+		if (entry.crc32 >= this->chksum_map.size()) {
+			return false;
+		}
+		std::uint32_t count = this->chksum_map[entry.crc32].count;
+		std::uint32_t checksumstart = this->chksum_map[entry.crc32].firstindex;
+		if (static_cast<std::uint64_t>(checksumstart) + count > this->checksums.size()) {
+			return false;
+		}
+
+		// Each checksum covers 32 KB of the entry, read a few of those at a time and stop at the first mismatch
+		buffer.resize(std::max<std::size_t>(options.bufferSize / GCF_CHECKSUM_BLOCK_SIZE, 1) * GCF_CHECKSUM_BLOCK_SIZE);
+		std::uint32_t checked = 0;
+		bool valid = true;
+		bool read = this->readEntryChunks(entry, 0, entry.length, buffer, [this, count, checksumstart, &checked, &valid](std::span<const std::byte> chunk) {
+			for (std::size_t offset = 0; offset < chunk.size() && checked < count; offset += GCF_CHECKSUM_BLOCK_SIZE) {
+				auto piece = chunk.subspan(offset, std::min<std::size_t>(GCF_CHECKSUM_BLOCK_SIZE, chunk.size() - offset));
+				auto [crc32, adler32] = ::computeCRC32AndAdler32(piece.data(), piece.size());
+				if ((crc32 ^ adler32) != this->checksums[checksumstart + checked++]) {
+					valid = false;
+					return false;
+				}
+			}
+			// Anything past the last checksum can't be checked
+			return checked < count;
+		});
+		return read && valid;
+	}, options, callback);
 }
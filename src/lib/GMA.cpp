@@ -1,7 +1,10 @@
 #include <vpkedit/GMA.h>
 
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
+#include <span>
+#include <string_view>
 
 #include <vpkedit/detail/CRC32.h>
 #include <vpkedit/detail/FileStream.h>
@@ -10,6 +13,13 @@
 using namespace vpkedit;
 using namespace vpkedit::detail;
 
+namespace {
+
+/// Entry data is copied through a buffer this big when baking
+constexpr std::size_t GMA_BAKE_CHUNK_SIZE = 1024 * 1024;
+
+} // namespace
+
 GMA::GMA(const std::string& fullFilePath_, PackFileOptions options_)
 		: PackFile(fullFilePath_, options_) {
 	this->type = PackFileType::GMA;
@@ -68,10 +78,7 @@ std::unique_ptr<PackFile> GMA::open(const std::string& path, PackFileOptions opt
 		if (!options.allowUppercaseLettersInFilenames) {
 			::toLowerCase(parentDir);
 		}
-		if (!gma->entries.contains(parentDir)) {
-			gma->entries[parentDir] = {};
-		}
-		gma->entries[parentDir].push_back(entry);
+		gma->insertBakedEntry(entry);
 
 		if (callback) {
 			callback(parentDir, entry);
@@ -82,30 +89,82 @@ std::unique_ptr<PackFile> GMA::open(const std::string& path, PackFileOptions opt
 }
 
 std::optional<std::vector<std::byte>> GMA::readEntry(const Entry& entry) const {
+	std::vector<std::byte> output(entry.length);
+	if (!this->readEntryRangeInternal(entry, 0, output)) {
+		return std::nullopt;
+	}
+	return output;
+}
+
+std::optional<EntryView> GMA::readEntryView(const Entry& entry) const {
 	if (entry.unbaked) {
-		// Get the stored data
-		for (const auto& [unbakedEntryDir, unbakedEntryList] : this->unbakedEntries) {
-			for (const Entry& unbakedEntry : unbakedEntryList) {
-				if (unbakedEntry.path == entry.path) {
-					std::vector<std::byte> unbakedData;
-					if (isEntryUnbakedUsingByteBuffer(unbakedEntry)) {
-						unbakedData = std::get<std::vector<std::byte>>(getEntryUnbakedData(unbakedEntry));
-					} else {
-						unbakedData = ::readFileData(std::get<std::string>(getEntryUnbakedData(unbakedEntry)));
-					}
-					return unbakedData;
-				}
-			}
-		}
+		return PackFile::readEntryView(entry);
+	}
+	const auto* archive = this->getMappedArchive(0);
+	if (!archive || entry.offset + entry.length > archive->size()) {
 		return std::nullopt;
 	}
+	return EntryView{archive->span().subspan(entry.offset, entry.length)};
+}
+
+bool GMA::readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	if (entry.unbaked) {
+		return this->readUnbakedEntryInto(entry, offset, buffer);
+	}
 	// It's baked into the file on disk
-	FileStream stream{this->fullFilePath};
-	if (!stream) {
+	return this->readArchiveInto(0, entry.offset + offset, buffer);
+}
+
+std::vector<std::string> GMA::verifyEntryChecksums(VerifyOptions options, const VerifyCallback& callback) const {
+	std::vector<Entry> entries;
+	this->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+		entries.push_back(entry);
+	}, false);
+
+	// The data section is one run of file data, walk it from front to back
+	std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return lhs.offset < rhs.offset;
+	});
+
+	const auto bufferSize = std::max<std::size_t>(options.bufferSize, 4096);
+	return this->verifyEntriesInParallel(entries, [this, bufferSize](const Entry& entry, std::vector<std::byte>& buffer) {
+		if (entry.crc32 == 0) {
+			return true;
+		}
+		std::uint32_t crc32 = 0;
+		buffer.resize(std::min<std::uint64_t>(entry.length, bufferSize));
+		for (std::uint64_t done = 0; done < entry.length;) {
+			auto chunk = std::span{buffer}.first(std::min<std::uint64_t>(entry.length - done, buffer.size()));
+			if (!this->readArchiveInto(0, entry.offset + done, chunk)) {
+				return false;
+			}
+			crc32 = ::computeCRC32(chunk.data(), chunk.size(), crc32);
+			done += chunk.size();
+		}
+		return crc32 == entry.crc32;
+	}, options, callback);
+}
+
+bool GMA::verifyFileChecksum() const {
+	// The CRC of everything before it is the last thing in the file
+	const auto* archive = this->getMappedArchive(0);
+	if (!archive || archive->size() < sizeof(std::uint32_t)) {
+		return false;
+	}
+	auto data = archive->span();
+	std::uint32_t fileCRC;
+	std::memcpy(&fileCRC, data.data() + data.size() - sizeof(fileCRC), sizeof(fileCRC));
+	if (fileCRC == 0) {
+		return true;
+	}
+	return ::computeCRC32Parallel(data.data(), data.size() - sizeof(fileCRC)) == fileCRC;
+}
+
+std::optional<PackFile::EntryDataLocation> GMA::getEntryDataLocation(const Entry& entry) const {
+	if (entry.unbaked) {
 		return std::nullopt;
 	}
-	stream.seekInput(entry.offset);
-	return stream.readBytes(entry.length);
+	return EntryDataLocation{0, entry.offset, {}};
 }
 
 Entry& GMA::addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) {
@@ -124,11 +183,7 @@ Entry& GMA::addEntryInternal(Entry& entry, const std::string& filename_, std::ve
 	// Offset will be reset when it's baked
 	entry.offset = 0;
 
-	if (!this->unbakedEntries.contains(dir)) {
-		this->unbakedEntries[dir] = {};
-	}
-	this->unbakedEntries.at(dir).push_back(entry);
-	return this->unbakedEntries.at(dir).back();
+	return this->insertUnbakedEntry(dir, entry);
 }
 
 bool GMA::bake(const std::string& outputDir_, const Callback& callback) {
@@ -136,84 +191,135 @@ bool GMA::bake(const std::string& outputDir_, const Callback& callback) {
 	std::string outputDir = this->getBakeOutputDir(outputDir_);
 	std::string outputPath = outputDir + '/' + this->getFilename();
 
-	// Reconstruct data for ease of access
+	// Reconstruct data for ease of access.
+	// The entries aren't touched until the new file is in place, their new offsets and lengths are kept on the side
+	auto bakedEntries = this->copyBakedEntries();
 	std::vector<Entry*> entriesToBake;
-	for (auto& [entryDir, entryList] : this->entries) {
-		for (auto& entry : entryList) {
-			entriesToBake.push_back(&entry);
-		}
+	for (auto& entry : bakedEntries) {
+		entriesToBake.push_back(&entry);
 	}
 	for (auto& [entryDir, entryList] : this->unbakedEntries) {
 		for (auto& entry : entryList) {
 			entriesToBake.push_back(&entry);
 		}
 	}
+	std::vector<std::uint64_t> newOffsets(entriesToBake.size());
+	std::vector<std::uint64_t> newLengths(entriesToBake.size());
 
-	// Read data before overwriting, we don't know if we're writing to ourself
-	std::vector<std::byte> fileData;
-	for (auto* entry : entriesToBake) {
-		if (auto binData = this->readEntry(*entry)) {
-			fileData.insert(fileData.end(), binData->begin(), binData->end());
+	// The tree comes before the data, so anything that obviously can't be read is left empty before it's written
+	const auto* archive = this->getMappedArchive(0);
+	for (std::size_t i = 0; i < entriesToBake.size(); i++) {
+		const auto* entry = entriesToBake[i];
+		bool readable;
+		if (!entry->unbaked) {
+			readable = archive && entry->offset + entry->length <= archive->size();
+		} else if (isEntryUnbakedUsingByteBuffer(*entry)) {
+			readable = true;
 		} else {
-			// Offsets are fixed later
-			entry->length = 0;
+			std::error_code ec;
+			readable = std::filesystem::file_size(std::get<std::string>(getEntryUnbakedData(*entry)), ec) >= entry->length && !ec;
+		}
+		newLengths[i] = readable ? entry->length : 0;
+	}
+
+	// Header and file tree, they're small enough to put together in memory
+	std::vector<std::byte> tree;
+	const auto append = [&tree](const auto& value) {
+		auto bytes = std::as_bytes(std::span{&value, 1});
+		tree.insert(tree.end(), bytes.begin(), bytes.end());
+	};
+	const auto appendString = [&tree](std::string_view str) {
+		auto bytes = std::as_bytes(std::span{str});
+		tree.insert(tree.end(), bytes.begin(), bytes.end());
+		tree.push_back(std::byte{0});
+	};
+	append(this->header.signature);
+	append(this->header.version);
+	append(this->header.steamID);
+	append(this->header.timestamp);
+	appendString(this->header.requiredContent);
+	appendString(this->header.addonName);
+	appendString(this->header.addonDescription);
+	appendString(this->header.addonAuthor);
+	append(this->header.addonVersion);
+	for (std::uint32_t i = 1; i <= entriesToBake.size(); i++) {
+		append(i);
+		const auto* entry = entriesToBake[i - 1];
+		appendString(entry->path);
+		append(newLengths[i - 1]);
+		append(this->options.gma_writeCRCs ? entry->crc32 : static_cast<std::uint32_t>(0));
+
+		if (callback) {
+			callback(entry->getParentPath(), *entry);
 		}
 	}
+	append(static_cast<std::uint32_t>(0));
 
+	// Write to a temporary file, we might be baking over the file the data is being read from.
+	// The CRC of everything written is kept up to date as it's written
+	const auto tempOutputPath = outputPath + ".tmp";
+	bool success = true;
+	std::uint64_t offset = tree.size();
 	{
-		FileStream stream{outputPath, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
-		stream.seekOutput(0);
-
-		// Header
-		stream.write(this->header.signature);
-		stream.write(this->header.version);
-		stream.write(this->header.steamID);
-		stream.write(this->header.timestamp);
-		stream.write(this->header.requiredContent);
-		stream.write(this->header.addonName);
-		stream.write(this->header.addonDescription);
-		stream.write(this->header.addonAuthor);
-		stream.write(this->header.addonVersion);
-
-		// File tree
-		for (std::uint32_t i = 1; i <= entriesToBake.size(); i++) {
-			stream.write(i);
-			auto* entry = entriesToBake[i - 1];
-			stream.write(entry->path);
-			stream.write(entry->length);
-			stream.write<std::uint32_t>(this->options.gma_writeCRCs ? entry->crc32 : 0);
-
-			if (callback) {
-				callback(entry->getParentPath(), *entry);
-			}
+		FileStream stream{tempOutputPath, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
+		std::uint64_t dataSize = 0;
+		for (auto length : newLengths) {
+			dataSize += length;
 		}
-		stream.write(static_cast<std::uint32_t>(0));
+		::preallocateFile(tempOutputPath, 0, tree.size() + dataSize + sizeof(std::uint32_t));
+
+		std::uint32_t crc = 0;
+		const auto write = [this, &stream, &crc](std::span<const std::byte> data) {
+			stream.writeBytes(data);
+			if (this->options.gma_writeCRCs) {
+				crc = ::computeCRC32(data.data(), data.size(), crc);
+			}
+		};
+		write(tree);
 
-		// Fix offsets
-		std::size_t offset = stream.tellOutput();
-		for (auto* entry : entriesToBake) {
-			entry->offset = offset;
-			offset += entry->length;
+		// File data, copied a chunk at a time
+		std::vector<std::byte> chunk(GMA_BAKE_CHUNK_SIZE);
+		for (std::size_t i = 0; success && i < entriesToBake.size(); i++) {
+			for (std::uint64_t copied = 0; copied < newLengths[i];) {
+				auto toCopy = std::span{chunk}.first(std::min<std::uint64_t>(newLengths[i] - copied, chunk.size()));
+				if (!this->readEntryRangeInternal(*entriesToBake[i], copied, toCopy)) {
+					success = false;
+					break;
+				}
+				write(toCopy);
+				copied += toCopy.size();
+			}
+			newOffsets[i] = offset;
+			offset += newLengths[i];
 		}
 
-		// File data
-		stream.writeBytes(fileData);
+		stream.write(crc);
+		stream.flush();
+		success &= static_cast<bool>(stream);
 	}
 
-	// CRC of everything that's been written
-	std::uint32_t crc = 0;
-	if (this->options.gma_writeCRCs) {
-		auto fileSize = std::filesystem::file_size(outputPath);
-		FileStream stream{outputPath};
-		stream.seekInput(0);
-		crc = ::computeCRC32(stream.readBytes(fileSize));
+	// The file being baked over can go now
+	this->closeArchives();
+	std::error_code ec;
+	if (success) {
+		std::filesystem::rename(tempOutputPath, outputPath, ec);
 	}
-	{
-		FileStream stream{outputPath, FILESTREAM_OPT_APPEND};
-		stream.write(crc);
+	if (!success || ec) {
+		std::filesystem::remove(tempOutputPath, ec);
+		return false;
+	}
+
+	// The new file is in place, now the entries can point into it
+	for (std::size_t i = 0; i < entriesToBake.size(); i++) {
+		entriesToBake[i]->offset = newOffsets[i];
+		entriesToBake[i]->length = newLengths[i];
 	}
 
 	// Clean up
+	this->entries.clear();
+	for (const auto& entry : bakedEntries) {
+		this->insertBakedEntry(entry);
+	}
 	this->mergeUnbakedEntries();
 	PackFile::setFullFilePath(outputDir);
 	return true;
@@ -1,22 +1,143 @@
 #include <vpkedit/PackFile.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <filesystem>
+#include <limits>
+#include <tuple>
 #include <utility>
 
+#include <vpkedit/detail/FileStream.h>
+#include <vpkedit/detail/IOQueue.h>
 #include <vpkedit/detail/Misc.h>
+#include <vpkedit/detail/Parallel.h>
 #include <vpkedit/BSP.h>
 #include <vpkedit/GCF.h>
 #include <vpkedit/GMA.h>
 #include <vpkedit/VPK.h>
 #include <vpkedit/ZIP.h>
 
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace vpkedit;
 using namespace vpkedit::detail;
 
+namespace {
+
+/// Entries closer together than this are read in one go, reading the gap is cheaper than another seek
+constexpr std::uint64_t BATCH_READ_MAX_GAP = 64 * 1024;
+
+/// Runs of nearby entries stop growing past this size, unless a single entry is bigger
+constexpr std::uint64_t BATCH_READ_MAX_LENGTH = 1024 * 1024;
+
+/// How many runs can be queued with the kernel at once
+constexpr std::uint32_t BATCH_READ_QUEUE_DEPTH = 16;
+
+/// Stop queueing runs once this much data is waiting to be read, unless nothing else is
+constexpr std::uint64_t BATCH_READ_MAX_IN_FLIGHT = 16 * 1024 * 1024;
+
+/// Each read is a ranged read, which every format can do without touching the rest of the entry
+class RangedEntryReader : public EntryReader {
+public:
+	RangedEntryReader(const PackFile& packFile_, Entry entry_)
+			: EntryReader(entry_.length)
+			, packFile(packFile_)
+			, entry(std::move(entry_)) {}
+
+protected:
+	bool readInternal(std::span<std::byte> buffer) override {
+		return this->packFile.readEntryRangeInto(this->entry, this->position, buffer);
+	}
+
+	const PackFile& packFile;
+	Entry entry;
+};
+
+#ifdef __linux__
+/// Keep writing until the whole buffer is written
+bool writeAll(int fd, std::span<const std::byte> buffer) {
+	while (!buffer.empty()) {
+		auto bytesWritten = ::write(fd, buffer.data(), buffer.size());
+		if (bytesWritten < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesWritten <= 0) {
+			return false;
+		}
+		buffer = buffer.subspan(bytesWritten);
+	}
+	return true;
+}
+#endif
+
+/// Make an entry path safe to write to on this platform, or nothing if it would end up outside the output directory
+std::optional<std::string> getExtractPath(const std::string& outputDir, const std::string& entryPath) {
+#ifdef _WIN32
+	// Remove bad characters from the filepath
+	std::string path;
+	path.reserve(entryPath.size());
+	for (char c : entryPath) {
+		switch (c) {
+			case '<': path += "_LT_"; break;
+			case '>': path += "_GT_"; break;
+			case ':': path += "_COLON_"; break;
+			case '"': path += "_QUOT_"; break;
+			case '|': path += "_BAR_"; break;
+			case '?': path += "_QMARK_"; break;
+			case '*': path += "_AST_"; break;
+			default: path += c; break;
+		}
+	}
+
+	// Replace bad filenames
+	const auto filenameStart = path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1;
+	std::filesystem::path filename{path.substr(filenameStart)};
+	auto stem = filename.stem().string();
+	auto extension = filename.extension().string();
+	std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return std::toupper(c); });
+	if (stem == "CON" || stem == "PRN" || stem == "AUX" || stem == "NUL" ||
+	    ((stem.starts_with("COM") || stem.starts_with("LPT")) && stem.length() == 4 && stem[3] >= '1' && stem[3] <= '9')) {
+		path.resize(filenameStart);
+		path += '_' + stem + '_' + extension;
+	}
+
+	// Files cannot end with a period - weird
+	if (extension == ".") {
+		path.pop_back();
+	}
+#else
+	const auto& path = entryPath;
+#endif
+
+	// Pack files are untrusted, an entry named with .. or a root can't be allowed to escape
+	const auto normalPath = std::filesystem::path{path}.lexically_normal();
+	if (normalPath.empty() || normalPath.has_root_path() || *normalPath.begin() == "." || *normalPath.begin() == "..") {
+		return std::nullopt;
+	}
+	return outputDir.empty() ? normalPath.generic_string() : outputDir + '/' + normalPath.generic_string();
+}
+
+} // namespace
+
+std::size_t PackFile::EntryPathHash::operator()(std::string_view path) const noexcept {
+	return ::hashEntryPath(path);
+}
+
+bool PackFile::EntryPathEqual::operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+	return ::compareEntryPaths(lhs, rhs, this->caseSensitive);
+}
+
 PackFile::PackFile(std::string fullFilePath_, PackFileOptions options_)
 		: fullFilePath(std::move(fullFilePath_))
-		, options(options_) {}
+		, options(options_)
+		, entries(options_.allowUppercaseLettersInFilenames)
+		, unbakedEntryIndex(0, EntryPathHash{}, EntryPathEqual{options_.allowUppercaseLettersInFilenames})
+		, archiveHandles(options_.maxOpenArchives) {}
 
 std::unique_ptr<PackFile> PackFile::open(const std::string& path, PackFileOptions options, const Callback& callback) {
 	auto extension = std::filesystem::path(path).extension().string();
@@ -34,7 +155,7 @@ PackFileOptions PackFile::getOptions() const {
 	return this->options;
 }
 
-std::vector<std::string> PackFile::verifyEntryChecksums() const {
+std::vector<std::string> PackFile::verifyEntryChecksums(VerifyOptions /*options*/, const VerifyCallback& /*callback*/) const {
 	return {};
 }
 
@@ -43,28 +164,181 @@ bool PackFile::verifyFileChecksum() const {
 }
 
 std::optional<Entry> PackFile::findEntry(const std::string& filename_, bool includeUnbaked) const {
-	auto filename = filename_;
-	::normalizeSlashes(filename);
-	if (!this->options.allowUppercaseLettersInFilenames) {
-		::toLowerCase(filename);
+	// The index hash and comparison normalize the path themselves
+	if (auto row = this->entries.find(filename_)) {
+		Entry entry = createNewEntry();
+		this->entries.get(*row, entry);
+		return entry;
+	}
+	if (includeUnbaked) {
+		if (auto it = this->unbakedEntryIndex.find(std::string_view{filename_}); it != this->unbakedEntryIndex.end()) {
+			return it->second.directory->at(it->second.index);
+		}
+	}
+	return std::nullopt;
+}
+
+bool PackFile::readEntryInto(const Entry& entry, std::span<std::byte> buffer) const {
+	if (buffer.size() < entry.length) {
+		return false;
 	}
-	auto [dir, name] = ::splitFilenameAndParentDir(filename);
+	return this->readEntryRangeInternal(entry, 0, buffer.first(entry.length));
+}
 
-	if (this->entries.contains(dir)) {
-		for (const Entry& entry : this->entries.at(dir)) {
-			if (entry.path == filename) {
-				return entry;
+bool PackFile::readEntryInto(const Entry& entry, std::vector<std::byte>& buffer) const {
+	buffer.resize(entry.length);
+	return this->readEntryRangeInternal(entry, 0, buffer);
+}
+
+std::optional<std::vector<std::byte>> PackFile::readEntryRange(const Entry& entry, std::uint64_t offset, std::uint64_t length) const {
+	if (offset > entry.length) {
+		return std::nullopt;
+	}
+	std::vector<std::byte> out(std::min(length, entry.length - offset));
+	if (!this->readEntryRangeInternal(entry, offset, out)) {
+		return std::nullopt;
+	}
+	return out;
+}
+
+bool PackFile::readEntryRangeInto(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	if (offset > entry.length || buffer.size() > entry.length - offset) {
+		return false;
+	}
+	return this->readEntryRangeInternal(entry, offset, buffer);
+}
+
+std::optional<EntryView> PackFile::readEntryView(const Entry& entry) const {
+	auto data = this->readEntry(entry);
+	if (!data) {
+		return std::nullopt;
+	}
+	return EntryView{std::move(*data)};
+}
+
+void PackFile::readEntries(std::span<const Entry> entries_, const ReadCallback& callback) const {
+	struct Request {
+		const Entry* entry;
+		EntryDataLocation location;
+		/// Bytes to read from the file, the rest is in the prefix
+		std::uint64_t length;
+	};
+	std::vector<Request> requests;
+	requests.reserve(entries_.size());
+
+	std::vector<std::byte> buffer;
+	for (const auto& entry : entries_) {
+		if (auto location = this->getEntryDataLocation(entry); location && location->prefix.size() <= entry.length) {
+			requests.push_back({&entry, *location, entry.length - location->prefix.size()});
+			continue;
+		}
+		// Nothing to batch, read it on its own
+		if (this->readEntryInto(entry, buffer)) {
+			callback(entry, buffer);
+		} else {
+			callback(entry, std::nullopt);
+		}
+	}
+
+	std::sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs) {
+		return std::tie(lhs.location.archiveIndex, lhs.location.offset) < std::tie(rhs.location.archiveIndex, rhs.location.offset);
+	});
+
+	struct Run {
+		std::uint16_t archiveIndex;
+		std::uint64_t offset;
+		std::uint64_t length;
+		/// Range of requests covered by this run
+		std::size_t begin;
+		std::size_t end;
+	};
+	std::vector<Run> runs;
+	for (std::size_t runBegin = 0, runEnd; runBegin < requests.size(); runBegin = runEnd) {
+		// Grow the run while the next entry is in the same file and close enough to the end of the run
+		const auto archiveIndex = requests[runBegin].location.archiveIndex;
+		const auto runOffset = requests[runBegin].location.offset;
+		auto runLength = requests[runBegin].length;
+		for (runEnd = runBegin + 1; runEnd < requests.size(); runEnd++) {
+			const auto& next = requests[runEnd];
+			if (next.location.archiveIndex != archiveIndex || next.location.offset > runOffset + runLength + BATCH_READ_MAX_GAP) {
+				break;
 			}
+			const auto nextEnd = std::max(runLength, next.location.offset - runOffset + next.length);
+			if (nextEnd > BATCH_READ_MAX_LENGTH) {
+				break;
+			}
+			runLength = nextEnd;
 		}
+		runs.push_back({archiveIndex, runOffset, runLength, runBegin, runEnd});
 	}
-	if (includeUnbaked && this->unbakedEntries.contains(dir)) {
-		for (const Entry& unbakedEntry : this->unbakedEntries.at(dir)) {
-			if (unbakedEntry.path == filename) {
-				return unbakedEntry;
+
+	// Buffers of finished runs are kept around to be reused by the next ones
+	std::vector<std::vector<std::byte>> runBuffers(runs.size());
+	std::vector<std::vector<std::byte>> spareBuffers;
+	std::vector<std::byte> entryData;
+
+	const auto dispatchRun = [&](std::size_t runIndex, bool success) {
+		const auto& run = runs[runIndex];
+		auto& runBuffer = runBuffers[runIndex];
+		for (std::size_t i = run.begin; i < run.end; i++) {
+			const auto& request = requests[i];
+			if (!success) {
+				callback(*request.entry, std::nullopt);
+				continue;
+			}
+			auto data = std::span{runBuffer}.subspan(request.location.offset - run.offset, request.length);
+			if (request.location.prefix.empty()) {
+				callback(*request.entry, data);
+				continue;
+			}
+			entryData.clear();
+			entryData.insert(entryData.end(), request.location.prefix.begin(), request.location.prefix.end());
+			entryData.insert(entryData.end(), data.begin(), data.end());
+			callback(*request.entry, entryData);
+		}
+		spareBuffers.push_back(std::move(runBuffer));
+	};
+
+	// Runs complete in whatever order the kernel finishes them, memory use is capped by the bytes in flight
+	IOQueue queue{BATCH_READ_QUEUE_DEPTH, this->options.asyncBatchReads};
+	// Synchronous reads gain nothing from queueing, keep the buffer hot for the callback instead
+	const std::uint64_t maxBytesInFlight = queue.isAsync() ? BATCH_READ_MAX_IN_FLIGHT : 0;
+	std::uint64_t bytesInFlight = 0;
+	std::size_t nextRun = 0;
+	while (nextRun < runs.size() || queue.getPendingCount()) {
+		while (nextRun < runs.size() && (!bytesInFlight || bytesInFlight + runs[nextRun].length <= maxBytesInFlight)) {
+			const auto& run = runs[nextRun];
+			auto handle = run.length ? this->getArchiveHandle(run.archiveIndex) : nullptr;
+			auto& runBuffer = runBuffers[nextRun];
+			if (!spareBuffers.empty()) {
+				runBuffer = std::move(spareBuffers.back());
+				spareBuffers.pop_back();
+			}
+			runBuffer.resize(run.length);
+			if (!handle) {
+				// Nothing to read, or nothing to read it from
+				dispatchRun(nextRun++, !run.length);
+				continue;
+			}
+			if (!queue.push({std::move(handle), run.offset, runBuffer, nextRun})) {
+				spareBuffers.push_back(std::move(runBuffer));
+				break;
 			}
+			bytesInFlight += run.length;
+			nextRun++;
 		}
+		queue.wait([&](std::size_t runIndex, bool success) {
+			bytesInFlight -= runs[runIndex].length;
+			dispatchRun(runIndex, success);
+		});
 	}
-	return std::nullopt;
+}
+
+std::unique_ptr<EntryReader> PackFile::openEntryStream(const Entry& entry) const {
+	// Unbaked data is looked up by path when it's read, don't hold a second copy of it
+	Entry entryCopy = entry;
+	entryCopy.unbakedData = "";
+	return std::make_unique<RangedEntryReader>(*this, std::move(entryCopy));
 }
 
 std::optional<std::string> PackFile::readEntryText(const Entry& entry) const {
@@ -81,6 +355,66 @@ std::optional<std::string> PackFile::readEntryText(const Entry& entry) const {
 	return out;
 }
 
+bool PackFile::extractEntry(const Entry& entry, const std::string& filePath) const {
+	std::vector<std::byte> buffer;
+	return this->writeEntryToFile(entry, filePath, buffer, ExtractOptions{}.bufferSize);
+}
+
+bool PackFile::extractIf(const std::string& outputDir, const EntryPredicate& predicate, ExtractOptions options, const ExtractCallback& callback) const {
+	struct Job {
+		Entry entry;
+		std::string filePath;
+		std::uint16_t archiveIndex;
+		std::uint64_t offset;
+	};
+	std::vector<Job> jobs;
+	this->runForAllEntries([&](const std::string&, const Entry& entry) {
+		if (predicate && !predicate(entry)) {
+			return;
+		}
+		// Entries that can't be extracted safely keep an empty path and fail when their turn comes
+		auto filePath = ::getExtractPath(outputDir, entry.path).value_or("");
+		if (auto location = this->getEntryDataLocation(entry)) {
+			jobs.push_back({entry, std::move(filePath), location->archiveIndex, location->offset});
+		} else {
+			// Whatever has no known location goes last
+			jobs.push_back({entry, std::move(filePath), std::numeric_limits<std::uint16_t>::max(), std::numeric_limits<std::uint64_t>::max()});
+		}
+	});
+
+	// Taking jobs in the order the data is stored keeps the threads reading close to each other
+	std::stable_sort(jobs.begin(), jobs.end(), [](const Job& lhs, const Job& rhs) {
+		return std::tie(lhs.archiveIndex, lhs.offset) < std::tie(rhs.archiveIndex, rhs.offset);
+	});
+
+	// Create every directory before any thread needs one
+	std::vector<std::string> directories;
+	directories.reserve(jobs.size());
+	for (const auto& job : jobs) {
+		if (job.filePath.empty()) {
+			continue;
+		}
+		directories.push_back(std::filesystem::path{job.filePath}.parent_path().string());
+	}
+	std::sort(directories.begin(), directories.end());
+	directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+	for (const auto& directory : directories) {
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+	}
+
+	const auto bufferSize = std::max<std::size_t>(options.bufferSize, 4096);
+	return ::runInParallel(options.threads, jobs.size(), [this, &jobs, bufferSize](std::size_t i, std::vector<std::byte>& buffer) {
+		return !jobs[i].filePath.empty() && this->writeEntryToFile(jobs[i].entry, jobs[i].filePath, buffer, bufferSize);
+	}, [&jobs, &callback](std::size_t i, bool success, std::size_t jobsDone) {
+		return !callback || callback(jobs[i].entry, success, jobsDone, jobs.size());
+	});
+}
+
+bool PackFile::extractAll(const std::string& outputDir, ExtractOptions options, const ExtractCallback& callback) const {
+	return this->extractIf(outputDir, nullptr, options, callback);
+}
+
 bool PackFile::isReadOnly() const {
 	return false;
 }
@@ -92,11 +426,7 @@ void PackFile::addEntry(const std::string& filename_, const std::string& pathToF
 
 	auto buffer = ::readFileData(pathToFile, 0);
 
-	Entry entry{};
-	entry.unbaked = true;
-	entry.unbakedUsingByteBuffer = false;
-	entry.unbakedData = pathToFile;
-
+	Entry entry = PackFile::createUnbakedFileEntry(pathToFile);
 	Entry& finalEntry = this->addEntryInternal(entry, filename_, buffer, options_);
 	finalEntry.unbakedData = pathToFile;
 }
@@ -126,53 +456,75 @@ bool PackFile::removeEntry(const std::string& filename_) {
 		return false;
 	}
 
-	auto filename = filename_;
-	if (!this->options.allowUppercaseLettersInFilenames) {
-		::toLowerCase(filename);
-	}
-	auto [dir, name] = ::splitFilenameAndParentDir(filename);
-
-	// Check unbaked entries first
-	if (this->unbakedEntries.contains(dir)) {
-		for (auto& [preexistingDir, unbakedEntryVec] : this->unbakedEntries) {
-			if (preexistingDir != dir) {
-				continue;
-			}
-			for (auto it = unbakedEntryVec.begin(); it != unbakedEntryVec.end(); ++it) {
-				if (it->path == filename) {
-					unbakedEntryVec.erase(it);
-					return true;
-				}
+	const auto removeFromDirectory = [](EntryIndex& index, EntryIndex::iterator it) {
+		auto [directory, removedIndex] = it->second;
+		index.erase(it);
+		directory->erase(directory->begin() + static_cast<std::vector<Entry>::difference_type>(removedIndex));
+
+		// Everything after the removed entry shifted down by one
+		for (std::size_t i = removedIndex; i < directory->size(); i++) {
+			auto& entry = directory->at(i);
+			if (auto shifted = index.find(std::string_view{entry.path}); shifted == index.end()) {
+				// This was a duplicate of the removed entry
+				index.emplace(entry.path, EntryLocation{directory, i});
+			} else if (shifted->second.directory == directory && shifted->second.index == i + 1) {
+				shifted->second.index = i;
 			}
 		}
+	};
+
+	// Check unbaked entries first
+	if (auto it = this->unbakedEntryIndex.find(std::string_view{filename_}); it != this->unbakedEntryIndex.end()) {
+		removeFromDirectory(this->unbakedEntryIndex, it);
+		return true;
 	}
 
 	// If it's not in regular entries either you can't remove it!
-	if (!this->entries.contains(dir))
-		return false;
-
-	for (auto it = this->entries.at(dir).begin(); it != this->entries.at(dir).end(); ++it) {
-		if (it->path == filename) {
-			this->entries.at(dir).erase(it);
-			return true;
-		}
+	if (auto row = this->entries.find(filename_)) {
+		this->entries.remove(*row);
+		this->bakedEntriesCacheValid = false;
+		return true;
 	}
 	return false;
 }
 
 const std::unordered_map<std::string, std::vector<Entry>>& PackFile::getBakedEntries() const {
-	return this->entries;
+	std::scoped_lock lock{this->cacheMutex};
+	if (!this->bakedEntriesCacheValid) {
+		this->bakedEntriesCache.clear();
+		this->entries.forEach([this](detail::EntryTable::Row row) {
+			auto& directory = this->bakedEntriesCache[std::string{this->entries.getParentPath(row)}];
+			this->entries.get(row, directory.emplace_back(createNewEntry()));
+		});
+		this->bakedEntriesCacheValid = true;
+	}
+	return this->bakedEntriesCache;
 }
 
 const std::unordered_map<std::string, std::vector<Entry>>& PackFile::getUnbakedEntries() const {
 	return this->unbakedEntries;
 }
 
-std::size_t PackFile::getEntryCount(bool includeUnbaked) const {
-	std::size_t count = 0;
-	for (const auto& [directory, entries_] : this->entries) {
-		count += entries_.size();
+void PackFile::runForAllEntries(const Callback& operation, bool includeUnbaked) const {
+	// Reuse one entry so its path and preload buffers are only allocated once
+	Entry entry = createNewEntry();
+	std::string directory;
+	this->entries.forEach([&](detail::EntryTable::Row row) {
+		this->entries.get(row, entry);
+		directory = this->entries.getParentPath(row);
+		operation(directory, entry);
+	});
+	if (includeUnbaked) {
+		for (const auto& [unbakedDirectory, unbakedEntryList] : this->unbakedEntries) {
+			for (const Entry& unbakedEntry : unbakedEntryList) {
+				operation(unbakedDirectory, unbakedEntry);
+			}
+		}
 	}
+}
+
+std::size_t PackFile::getEntryCount(bool includeUnbaked) const {
+	std::size_t count = this->entries.getEntryCount();
 	if (includeUnbaked) {
 		for (const auto& [directory, entries_] : this->unbakedEntries) {
 			count += entries_.size();
@@ -214,6 +566,71 @@ std::vector<std::string> PackFile::getSupportedFileTypes() {
 	return out;
 }
 
+void PackFile::insertBakedEntry(const Entry& entry) {
+	this->entries.add(entry);
+	this->bakedEntriesCacheValid = false;
+}
+
+Entry& PackFile::insertUnbakedEntry(const std::string& dir, Entry entry) {
+	auto& directory = this->unbakedEntries[dir];
+	directory.push_back(std::move(entry));
+	this->unbakedEntryIndex.emplace(directory.back().path, EntryLocation{&directory, directory.size() - 1});
+	return directory.back();
+}
+
+bool PackFile::readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	auto data = this->readEntry(entry);
+	if (!data || offset + buffer.size() > data->size()) {
+		return false;
+	}
+	std::copy_n(data->begin() + static_cast<std::ptrdiff_t>(offset), buffer.size(), buffer.begin());
+	return true;
+}
+
+std::optional<PackFile::EntryDataLocation> PackFile::getEntryDataLocation(const Entry& /*entry*/) const {
+	return std::nullopt;
+}
+
+std::vector<std::string> PackFile::verifyEntriesInParallel(std::span<const Entry> entries_, const EntryChecker& checker, VerifyOptions options, const VerifyCallback& callback) const {
+	std::vector<bool> failed(entries_.size());
+	::runInParallel(options.threads, entries_.size(), [&entries_, &checker](std::size_t i, std::vector<std::byte>& buffer) {
+		return checker(entries_[i], buffer);
+	}, [&entries_, &callback, &failed](std::size_t i, bool valid, std::size_t entriesDone) {
+		failed[i] = !valid;
+		return !callback || callback(entries_[i], valid, entriesDone, entries_.size());
+	});
+
+	std::vector<std::string> bad;
+	for (std::size_t i = 0; i < entries_.size(); i++) {
+		if (failed[i]) {
+			bad.push_back(entries_[i].path);
+		}
+	}
+	return bad;
+}
+
+bool PackFile::readUnbakedEntryInto(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	auto it = this->unbakedEntryIndex.find(std::string_view{entry.path});
+	if (it == this->unbakedEntryIndex.end()) {
+		return false;
+	}
+	const auto& unbakedEntry = it->second.directory->at(it->second.index);
+	if (isEntryUnbakedUsingByteBuffer(unbakedEntry)) {
+		const auto& unbakedData = std::get<std::vector<std::byte>>(getEntryUnbakedData(unbakedEntry));
+		if (offset + buffer.size() > unbakedData.size()) {
+			return false;
+		}
+		std::copy_n(unbakedData.begin() + static_cast<std::ptrdiff_t>(offset), buffer.size(), buffer.begin());
+		return true;
+	}
+	FileStream stream{std::get<std::string>(getEntryUnbakedData(unbakedEntry))};
+	if (!stream) {
+		return false;
+	}
+	stream.seekInput(offset);
+	return stream.readBytes(buffer);
+}
+
 std::string PackFile::getBakeOutputDir(const std::string& outputDir) const {
 	std::string out = outputDir;
 	if (!out.empty()) {
@@ -230,34 +647,139 @@ std::string PackFile::getBakeOutputDir(const std::string& outputDir) const {
 	return out;
 }
 
+std::vector<Entry> PackFile::copyBakedEntries() const {
+	std::vector<Entry> out;
+	out.reserve(this->entries.getEntryCount());
+	this->entries.forEach([this, &out](detail::EntryTable::Row row) {
+		this->entries.get(row, out.emplace_back(createNewEntry()));
+	});
+	return out;
+}
+
 void PackFile::mergeUnbakedEntries() {
 	for (auto& [dir, unbakedEntriesAndData] : this->unbakedEntries) {
 		for (Entry& unbakedEntry : unbakedEntriesAndData) {
-			if (!this->entries.contains(dir)) {
-				this->entries[dir] = {};
-			}
-
 			unbakedEntry.unbaked = false;
 
 			// Clear any data that might be stored in it
 			unbakedEntry.unbakedUsingByteBuffer = false;
 			unbakedEntry.unbakedData = "";
 
-			this->entries.at(dir).push_back(unbakedEntry);
+			this->insertBakedEntry(unbakedEntry);
 		}
 	}
 	this->unbakedEntries.clear();
+	this->unbakedEntryIndex.clear();
+}
+
+std::string PackFile::getArchiveFilepath(std::uint16_t /*archiveIndex*/) const {
+	return this->fullFilePath;
+}
+
+const MappedFile* PackFile::getMappedArchive(std::uint16_t archiveIndex) const {
+	std::scoped_lock lock{this->cacheMutex};
+	if (auto it = this->mappedArchives.find(archiveIndex); it != this->mappedArchives.end()) {
+		return &it->second;
+	}
+	MappedFile mappedFile{this->getArchiveFilepath(archiveIndex)};
+	if (!mappedFile) {
+		return nullptr;
+	}
+	return &this->mappedArchives.emplace(archiveIndex, std::move(mappedFile)).first->second;
+}
+
+std::shared_ptr<FileHandle> PackFile::getArchiveHandle(std::uint16_t archiveIndex) const {
+	return this->archiveHandles.acquire(archiveIndex, [this, archiveIndex] {
+		return this->getArchiveFilepath(archiveIndex);
+	});
+}
+
+bool PackFile::readArchiveInto(std::uint16_t archiveIndex, std::uint64_t offset, std::span<std::byte> buffer) const {
+	if (buffer.empty()) {
+		return true;
+	}
+	auto handle = this->getArchiveHandle(archiveIndex);
+	return handle && handle->read(offset, buffer);
+}
+
+bool PackFile::writeEntryToFile(const Entry& entry, const std::string& filePath, std::vector<std::byte>& buffer, std::size_t bufferSize) const {
+#ifdef __linux__
+	// Stored data is already exactly what goes in the file, let the kernel copy it without a trip through memory
+	if (auto location = this->getEntryDataLocation(entry); location && location->prefix.size() <= entry.length) {
+		if (auto handle = this->getArchiveHandle(location->archiveIndex)) {
+			if (int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666); fd >= 0) {
+				bool success = ::writeAll(fd, location->prefix) && handle->copyTo(location->offset, entry.length - location->prefix.size(), fd);
+				success &= ::close(fd) == 0;
+				if (success) {
+					return true;
+				}
+			}
+			// Try again the portable way below, it starts the file over
+		}
+	}
+#endif
+
+	if (entry.length <= bufferSize) {
+		if (!this->readEntryInto(entry, buffer)) {
+			return false;
+		}
+		FileStream writer{filePath, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE};
+		if (!writer) {
+			return false;
+		}
+		writer.writeBytes(std::span<const std::byte>{buffer});
+		writer.flush();
+		return static_cast<bool>(writer);
+	}
+
+	auto reader = this->openEntryStream(entry);
+	if (!reader) {
+		return false;
+	}
+	FileStream writer{filePath, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE};
+	if (!writer) {
+		return false;
+	}
+	buffer.resize(bufferSize);
+	while (reader->tell() < entry.length) {
+		auto bytesRead = reader->read(buffer);
+		if (!bytesRead || !*bytesRead) {
+			return false;
+		}
+		writer.writeBytes(std::span<const std::byte>{buffer}.first(*bytesRead));
+	}
+	writer.flush();
+	return static_cast<bool>(writer);
+}
+
+void PackFile::closeArchives() {
+	{
+		std::scoped_lock lock{this->cacheMutex};
+		this->mappedArchives.clear();
+	}
+	this->archiveHandles.clear();
 }
 
 void PackFile::setFullFilePath(const std::string& outputDir) {
 	// Assumes PackFile::getBakeOutputDir is the input for outputDir
 	this->fullFilePath = outputDir + '/' + this->getFilename();
+
+	// Any open archives are at the old location
+	this->closeArchives();
 }
 
 Entry PackFile::createNewEntry() {
 	return {};
 }
 
+Entry PackFile::createUnbakedFileEntry(const std::string& pathToFile) {
+	Entry entry{};
+	entry.unbaked = true;
+	entry.unbakedUsingByteBuffer = false;
+	entry.unbakedData = pathToFile;
+	return entry;
+}
+
 const std::variant<std::string, std::vector<std::byte>>& PackFile::getEntryUnbakedData(const Entry& entry) {
 	return entry.unbakedData;
 }
@@ -1,11 +1,19 @@
 #include <vpkedit/VPK.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <filesystem>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include <MD5.h>
 #include <vpkedit/detail/CRC32.h>
 #include <vpkedit/detail/FileStream.h>
 #include <vpkedit/detail/Misc.h>
+#include <vpkedit/detail/Parallel.h>
 
 using namespace vpkedit;
 using namespace vpkedit::detail;
@@ -27,12 +35,162 @@ std::string removeVPKAndOrDirSuffix(const std::string& path) {
 	return filename;
 }
 
+/// Entry data is copied through a buffer this big when baking
+constexpr std::size_t VPK_BAKE_CHUNK_SIZE = 1024 * 1024;
+
+/// CRC32, preload length, archive index, offset, length, terminator
+constexpr std::size_t VPK_ENTRY_METADATA_SIZE = sizeof(std::uint32_t) + sizeof(std::uint16_t) * 2 + sizeof(std::uint32_t) * 2 + sizeof(std::uint16_t);
+
 std::string padArchiveIndex(int num) {
 	static constexpr int WIDTH = 3;
     auto numStr = std::to_string(num);
     return std::string(WIDTH - std::min<std::string::size_type>(WIDTH, numStr.length()), '0') + numStr;
 }
 
+/// Feed data of any length to an MD5, it only takes 32-bit lengths at a time
+void updateMD5(MD5& hash, std::span<const std::byte> data) {
+	while (!data.empty()) {
+		auto length = std::min<std::size_t>(data.size(), std::numeric_limits<MD5::size_type>::max());
+		hash.update(data.data(), static_cast<MD5::size_type>(length));
+		data = data.subspan(length);
+	}
+}
+
+std::array<std::byte, 16> finalizeMD5(MD5& hash) {
+	std::array<std::byte, 16> digest{};
+	hash.finalize(reinterpret_cast<unsigned char*>(digest.data()));
+	return digest;
+}
+
+/// A file found by VPK::createFromDirectory, and everything about its contents the VPK needs
+struct ContentFile {
+	std::string entryPath;
+	std::string path;
+	EntryOptions options;
+	std::uint64_t length = 0;
+	std::uint32_t crc32 = 0;
+	std::vector<std::byte> preloadedData;
+	std::array<std::byte, 16> md5{};
+	bool readable = false;
+};
+
+/// For jobs where one failing means the rest would be wasted work
+bool stopOnFailure(std::size_t, bool success, std::size_t) {
+	return success;
+}
+
+/// Find every regular file below the content directory. Each thread lists one directory at a time,
+/// and the subdirectories it finds are handed to whichever thread is free next
+std::vector<ContentFile> findContentFiles(const std::string& contentPath, std::size_t threads) {
+	std::error_code ec;
+	auto root = std::filesystem::absolute(contentPath, ec);
+	if (ec) {
+		return {};
+	}
+	std::size_t rootLength;
+	try {
+		rootLength = root.string().length();
+	} catch (const std::exception&) {
+		return {}; // Likely a Unicode error, unsupported filename
+	}
+
+	std::mutex mutex;
+	std::condition_variable directoriesAvailable;
+	std::vector<std::filesystem::path> directories{root};
+	std::size_t busyThreads = 0;
+	std::vector<ContentFile> files;
+
+	// Each job is one thread listing directories until there are none left
+	const auto threadCount = ::getThreadCount(threads);
+	::runInParallel(threadCount, threadCount, [&](std::size_t, std::vector<std::byte>&) {
+		std::unique_lock lock{mutex};
+		while (true) {
+			directoriesAvailable.wait(lock, [&] {
+				return !directories.empty() || busyThreads == 0;
+			});
+			if (directories.empty()) {
+				// Nobody is listing a directory that could have more in it
+				directoriesAvailable.notify_all();
+				return true;
+			}
+			auto directory = std::move(directories.back());
+			directories.pop_back();
+			busyThreads++;
+			lock.unlock();
+
+			std::vector<std::filesystem::path> foundDirectories;
+			std::vector<ContentFile> foundFiles;
+			std::error_code iteratorEC;
+			for (std::filesystem::directory_iterator it{directory, std::filesystem::directory_options::skip_permission_denied, iteratorEC}; !iteratorEC && it != std::filesystem::directory_iterator{}; it.increment(iteratorEC)) {
+				std::error_code typeEC;
+				// Symlinked directories aren't followed, symlinked files are
+				if (it->is_directory(typeEC) && !it->is_symlink(typeEC)) {
+					foundDirectories.push_back(it->path());
+					continue;
+				}
+				if (!it->is_regular_file(typeEC)) {
+					continue;
+				}
+				ContentFile file;
+				try {
+					file.path = it->path().string();
+					file.entryPath = file.path.substr(rootLength);
+				} catch (const std::exception&) {
+					continue; // Likely a Unicode error, unsupported filename
+				}
+				::normalizeSlashes(file.entryPath);
+				if (!file.entryPath.empty()) {
+					foundFiles.push_back(std::move(file));
+				}
+			}
+
+			lock.lock();
+			std::move(foundDirectories.begin(), foundDirectories.end(), std::back_inserter(directories));
+			std::move(foundFiles.begin(), foundFiles.end(), std::back_inserter(files));
+			busyThreads--;
+			directoriesAvailable.notify_all();
+		}
+	});
+	return files;
+}
+
+/// Read the file once, computing its CRC and MD5 (if asked to) and taking out the bytes to preload
+void hashContentFile(ContentFile& file, bool computeMD5, std::vector<std::byte>& chunk) {
+	FileStream stream{file.path};
+	std::error_code ec;
+	file.length = std::filesystem::file_size(file.path, ec);
+	if (!stream || ec) {
+		return;
+	}
+
+	const auto preloadBytes = std::min<std::uint64_t>({file.options.vpk_preloadBytes, VPK_MAX_PRELOAD_BYTES, file.length});
+	file.preloadedData.resize(preloadBytes);
+	if (!stream.readBytes(file.preloadedData)) {
+		return;
+	}
+	file.crc32 = ::computeCRC32(file.preloadedData);
+
+	MD5 entryMD5;
+	if (computeMD5) {
+		entryMD5.update(file.preloadedData.data(), static_cast<MD5::size_type>(file.preloadedData.size()));
+	}
+	for (std::uint64_t remaining = file.length - preloadBytes; remaining > 0;) {
+		auto toHash = std::span{chunk}.first(std::min<std::uint64_t>(remaining, chunk.size()));
+		if (!stream.readBytes(toHash)) {
+			return;
+		}
+		file.crc32 = ::computeCRC32(toHash.data(), toHash.size(), file.crc32);
+		if (computeMD5) {
+			entryMD5.update(toHash.data(), static_cast<MD5::size_type>(toHash.size()));
+		}
+		remaining -= toHash.size();
+	}
+	if (computeMD5) {
+		entryMD5.finalize(reinterpret_cast<unsigned char*>(file.md5.data()));
+	}
+	file.readable = true;
+}
+
 } // namespace
 
 VPK::VPK(const std::string& fullFilePath_, PackFileOptions options_)
@@ -71,33 +229,50 @@ std::unique_ptr<PackFile> VPK::createFromDirectory(const std::string& vpkPath, c
 }
 
 std::unique_ptr<PackFile> VPK::createFromDirectoryProcedural(const std::string& vpkPath, const std::string& contentPath, const EntryCreationCallback& creationCallback, PackFileOptions options, const Callback& bakeCallback) {
-	auto vpk = VPK::createEmpty(vpkPath, options);
-	if (!std::filesystem::exists(contentPath) || std::filesystem::status(contentPath).type() != std::filesystem::file_type::directory) {
-		return vpk;
+	auto packFile = VPK::createEmpty(vpkPath, options);
+	if (!packFile || !std::filesystem::exists(contentPath) || std::filesystem::status(contentPath).type() != std::filesystem::file_type::directory) {
+		return packFile;
 	}
-	for (const auto& file : std::filesystem::recursive_directory_iterator(contentPath, std::filesystem::directory_options::skip_permission_denied)) {
-		if (!file.is_regular_file()) {
-			continue;
-		}
-		std::string entryPath;
-		try {
-			entryPath = std::filesystem::absolute(file.path()).string().substr(std::filesystem::absolute(contentPath).string().length());
-			::normalizeSlashes(entryPath);
-		} catch (const std::exception&) {
-			continue; // Likely a Unicode error, unsupported filename
+	auto* vpk = static_cast<VPK*>(packFile.get());
+
+	// Directories are listed in whatever order the threads get to them, sorting makes
+	// the entries (and so the archive each one lands in) the same every time
+	auto files = ::findContentFiles(contentPath, options.vpk_createFromDirectoryThreads);
+	std::sort(files.begin(), files.end(), [](const ContentFile& lhs, const ContentFile& rhs) {
+		return lhs.entryPath < rhs.entryPath;
+	});
+
+	// The callback is only ever called from this thread
+	if (creationCallback) {
+		for (auto& file : files) {
+			auto [saveToDir, preloadBytes] = creationCallback(file.entryPath);
+			file.options = { .vpk_saveToDirectory = saveToDir, .vpk_preloadBytes = preloadBytes };
 		}
-		if (entryPath.empty()) {
+	}
+
+	// Each file is read once up front. Its MD5 is kept for bake, so bake only has to read it again to copy it
+	const bool computeMD5 = vpk->header1.version != 1 && options.vpk_generateMD5Entries;
+	::runInParallel(options.vpk_createFromDirectoryThreads, files.size(), [&files, computeMD5](std::size_t i, std::vector<std::byte>& chunk) {
+		chunk.resize(VPK_BAKE_CHUNK_SIZE);
+		::hashContentFile(files[i], computeMD5, chunk);
+		return true;
+	});
+
+	for (auto& file : files) {
+		if (!file.readable) {
 			continue;
 		}
-		if (creationCallback) {
-			auto [saveToDir, preloadBytes] = creationCallback(entryPath);
-			vpk->addEntry(entryPath, file.path().string(), { .vpk_saveToDirectory = saveToDir, .vpk_preloadBytes = preloadBytes });
-		} else {
-			vpk->addEntry(entryPath, file.path().string(), {});
+		Entry entry = PackFile::createUnbakedFileEntry(file.path);
+		entry.length = file.length;
+		entry.crc32 = file.crc32;
+		entry.vpk_preloadedData = std::move(file.preloadedData);
+		Entry& finalEntry = vpk->addPreparedEntry(entry, file.entryPath, file.options.vpk_saveToDirectory);
+		if (computeMD5) {
+			vpk->unbakedEntryMD5s[finalEntry.path] = file.md5;
 		}
 	}
 	vpk->bake("", bakeCallback);
-	return vpk;
+	return packFile;
 }
 
 std::unique_ptr<PackFile> VPK::open(const std::string& path, PackFileOptions options, const Callback& callback) {
@@ -156,9 +331,6 @@ std::unique_ptr<PackFile> VPK::openInternal(const std::string& path, PackFileOpt
 	        } else {
 		        fullDir = directory;
 	        }
-	        if (!vpk->entries.contains(fullDir)) {
-		        vpk->entries[fullDir] = {};
-	        }
 
             // Files
             while (true) {
@@ -194,12 +366,12 @@ std::unique_ptr<PackFile> VPK::openInternal(const std::string& path, PackFileOpt
                     entry.length += preloadedDataSize;
                 }
 
-                vpk->entries[fullDir].push_back(entry);
-
                 if (entry.vpk_archiveIndex != VPK_DIR_INDEX && entry.vpk_archiveIndex > vpk->numArchives) {
                     vpk->numArchives = entry.vpk_archiveIndex;
                 }
 
+                vpk->insertBakedEntry(entry);
+
 				if (callback) {
 					callback(fullDir, entry);
 				}
@@ -210,6 +382,16 @@ std::unique_ptr<PackFile> VPK::openInternal(const std::string& path, PackFileOpt
     // If there are no archives, -1 will be incremented to 0
     vpk->numArchives++;
 
+	// New entries fill up the last archive before starting another one, so saving touches as few archives as possible
+	if (vpk->numArchives > 0 && vpk->options.vpk_preferredChunkSize) {
+		std::error_code ec;
+		auto lastArchiveSize = std::filesystem::file_size(vpk->getArchiveFilepath(vpk->numArchives - 1), ec);
+		if (!ec && lastArchiveSize < vpk->options.vpk_preferredChunkSize) {
+			vpk->numArchives--;
+			vpk->currentlyFilledChunkSize = static_cast<std::uint32_t>(lastArchiveSize);
+		}
+	}
+
     // Read VPK2-specific data
     if (vpk->header1.version != 2)
         return packFile;
@@ -220,10 +402,8 @@ std::unique_ptr<PackFile> VPK::openInternal(const std::string& path, PackFileOpt
     if (vpk->header2.archiveMD5SectionSize % sizeof(MD5Entry) != 0)
         return nullptr;
 
-    vpk->md5Entries.clear();
     unsigned int entryNum = vpk->header2.archiveMD5SectionSize / sizeof(MD5Entry);
-    for (unsigned int i = 0; i < entryNum; i++)
-        vpk->md5Entries.push_back(reader.read<MD5Entry>());
+    reader.read(vpk->md5Entries, entryNum);
 
     if (vpk->header2.otherMD5SectionSize != 48)
 	    // This should always be 48
@@ -250,71 +430,117 @@ std::unique_ptr<PackFile> VPK::openInternal(const std::string& path, PackFileOpt
 }
 
 std::optional<std::vector<std::byte>> VPK::readEntry(const Entry& entry) const {
-    std::vector output(entry.length, static_cast<std::byte>(0));
-
-    if (!entry.vpk_preloadedData.empty()) {
-        std::copy(entry.vpk_preloadedData.begin(), entry.vpk_preloadedData.end(), output.begin());
-    }
+	std::vector<std::byte> output(entry.length);
+	if (!this->readEntryRangeInternal(entry, 0, output)) {
+		return std::nullopt;
+	}
+	return output;
+}
 
-    if (entry.length == entry.vpk_preloadedData.size()) {
-        return output;
-    }
+std::optional<EntryView> VPK::readEntryView(const Entry& entry) const {
+	if (entry.unbaked || !entry.vpk_preloadedData.empty()) {
+		// Preloaded data is stored apart from the rest of the file, so it needs to be stitched together
+		return PackFile::readEntryView(entry);
+	}
 
-    if (entry.unbaked) {
-        // Get the stored data
-        for (const auto& [unbakedEntryDir, unbakedEntryList] : this->unbakedEntries) {
-            for (const Entry& unbakedEntry : unbakedEntryList) {
-                if (unbakedEntry.path == entry.path) {
-	                std::vector<std::byte> unbakedData;
-	                if (isEntryUnbakedUsingByteBuffer(unbakedEntry)) {
-		                unbakedData = std::get<std::vector<std::byte>>(getEntryUnbakedData(unbakedEntry));
-	                } else {
-	                    unbakedData = ::readFileData(std::get<std::string>(getEntryUnbakedData(unbakedEntry)), unbakedEntry.vpk_preloadedData.size());
-                    }
-	                std::copy(unbakedData.begin(), unbakedData.end(), output.begin() + static_cast<long long>(entry.vpk_preloadedData.size()));
-	                return output;
-                }
-            }
-        }
+	const auto* archive = this->getMappedArchive(entry.vpk_archiveIndex);
+	if (!archive) {
 		return std::nullopt;
-    } else if (entry.vpk_archiveIndex != VPK_DIR_INDEX) {
-		// Stored in a numbered archive
-        FileStream stream{this->getTruncatedFilepath() + '_' + ::padArchiveIndex(entry.vpk_archiveIndex) + VPK_EXTENSION.data()};
-        if (!stream) {
-            return std::nullopt;
-        }
-        stream.seekInput(entry.offset);
-        auto bytes = stream.readBytes(entry.length - entry.vpk_preloadedData.size());
-        std::copy(bytes.begin(), bytes.end(), output.begin() + static_cast<long long>(entry.vpk_preloadedData.size()));
-    } else {
-		// Stored in this directory VPK
-        FileStream stream{this->fullFilePath};
-        if (!stream) {
-            return std::nullopt;
-        }
-        stream.seekInput(this->getHeaderLength() + this->header1.treeSize + entry.offset);
-        auto bytes = stream.readBytes(entry.length - entry.vpk_preloadedData.size());
-        std::copy(bytes.begin(), bytes.end(), output.begin() + static_cast<long long>(entry.vpk_preloadedData.size()));
-    }
+	}
+	auto offset = this->getEntryDataOffset(entry);
+	if (offset + entry.length > archive->size()) {
+		return std::nullopt;
+	}
+	return EntryView{archive->span().subspan(offset, entry.length)};
+}
 
-    return output;
+std::vector<std::string> VPK::verifyEntryChecksums(VerifyOptions options, const VerifyCallback& callback) const {
+	std::vector<Entry> entries;
+	this->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+		entries.push_back(entry);
+	}, false);
+
+	// Walk each archive from front to back, the threads take neighbouring entries so the disk reads stay sequential
+	std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return std::tie(lhs.vpk_archiveIndex, lhs.offset) < std::tie(rhs.vpk_archiveIndex, rhs.offset);
+	});
+
+	const auto bufferSize = std::max<std::size_t>(options.bufferSize, 4096);
+	return this->verifyEntriesInParallel(entries, [this, bufferSize](const Entry& entry, std::vector<std::byte>& buffer) {
+		// The CRC covers the preloaded data too, it comes first
+		const std::uint64_t preloadedLength = entry.vpk_preloadedData.size();
+		if (preloadedLength > entry.length) {
+			return false;
+		}
+		std::uint32_t crc32 = ::computeCRC32(entry.vpk_preloadedData.data(), entry.vpk_preloadedData.size());
+
+		buffer.resize(std::min<std::uint64_t>(entry.length - preloadedLength, bufferSize));
+		const auto dataOffset = this->getEntryDataOffset(entry);
+		for (std::uint64_t done = 0; done < entry.length - preloadedLength;) {
+			auto chunk = std::span{buffer}.first(std::min<std::uint64_t>(entry.length - preloadedLength - done, buffer.size()));
+			if (!this->readArchiveInto(entry.vpk_archiveIndex, dataOffset + done, chunk)) {
+				return false;
+			}
+			crc32 = ::computeCRC32(chunk.data(), chunk.size(), crc32);
+			done += chunk.size();
+		}
+		return crc32 == entry.crc32;
+	}, options, callback);
 }
 
-Entry& VPK::addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) {
-	auto filename = filename_;
-	if (!this->options.allowUppercaseLettersInFilenames) {
-		::toLowerCase(filename);
+bool VPK::verifyFileChecksum() const {
+	// Only v2 has checksums, and only when the section holding them is there
+	if (this->header1.version != 2 || this->header2.otherMD5SectionSize != 48) {
+		return true;
 	}
-	auto [dir, name] = ::splitFilenameAndParentDir(filename);
 
-	entry.path = filename;
+	// Hash the file front to back once, each section's checksum is worked out along the way
+	std::vector<std::byte> chunk(VPK_BAKE_CHUNK_SIZE);
+	MD5 wholeFileMD5;
+	const auto hashRange = [this, &chunk, &wholeFileMD5](std::uint64_t offset, std::uint64_t length, MD5* sectionMD5) {
+		while (length > 0) {
+			auto toHash = std::span{chunk}.first(std::min<std::uint64_t>(length, chunk.size()));
+			if (!this->readArchiveInto(VPK_DIR_INDEX, offset, toHash)) {
+				return false;
+			}
+			::updateMD5(wholeFileMD5, toHash);
+			if (sectionMD5) {
+				::updateMD5(*sectionMD5, toHash);
+			}
+			offset += toHash.size();
+			length -= toHash.size();
+		}
+		return true;
+	};
+	const std::uint64_t treeOffset = this->getHeaderLength();
+	const std::uint64_t dataOffset = treeOffset + this->header1.treeSize;
+	const std::uint64_t md5EntriesOffset = dataOffset + this->header2.fileDataSectionSize;
+	const std::uint64_t otherMD5Offset = md5EntriesOffset + this->header2.archiveMD5SectionSize;
+
+	MD5 treeMD5;
+	MD5 md5EntriesMD5;
+	if (!hashRange(0, treeOffset, nullptr) || !hashRange(treeOffset, this->header1.treeSize, &treeMD5) || !hashRange(dataOffset, this->header2.fileDataSectionSize, nullptr) || !hashRange(md5EntriesOffset, this->header2.archiveMD5SectionSize, &md5EntriesMD5)) {
+		return false;
+	}
+	// VPKs baked by older versions of this library left the tree and MD5 entry checksums out of the whole file checksum
+	MD5 oldWholeFileMD5 = wholeFileMD5;
+	if (!hashRange(otherMD5Offset, this->footer2.treeChecksum.size() + this->footer2.md5EntriesChecksum.size(), nullptr)) {
+		return false;
+	}
+
+	if (::finalizeMD5(treeMD5) != this->footer2.treeChecksum || ::finalizeMD5(md5EntriesMD5) != this->footer2.md5EntriesChecksum) {
+		return false;
+	}
+	if (::finalizeMD5(wholeFileMD5) != this->footer2.wholeFileChecksum && ::finalizeMD5(oldWholeFileMD5) != this->footer2.wholeFileChecksum) {
+		return false;
+	}
+	return !this->options.vpk_verifyMD5Entries || this->verifyMD5Entries();
+}
+
+Entry& VPK::addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) {
 	entry.crc32 = ::computeCRC32(buffer);
 	entry.length = buffer.size();
 
-	// Offset will be reset when it's baked
-	entry.offset = 0;
-	entry.vpk_archiveIndex = options_.vpk_saveToDirectory ? VPK_DIR_INDEX : this->numArchives;
-
 	if (options_.vpk_preloadBytes > 0) {
 		auto clampedPreloadBytes = std::clamp(options_.vpk_preloadBytes, 0u, buffer.size() > VPK_MAX_PRELOAD_BYTES ? VPK_MAX_PRELOAD_BYTES : static_cast<std::uint32_t>(buffer.size()));
 		entry.vpk_preloadedData.resize(clampedPreloadBytes);
@@ -322,10 +548,29 @@ Entry& VPK::addEntryInternal(Entry& entry, const std::string& filename_, std::ve
 		buffer.erase(buffer.begin(), buffer.begin() + clampedPreloadBytes);
 	}
 
+	Entry& finalEntry = this->addPreparedEntry(entry, filename_, options_.vpk_saveToDirectory);
+	// Any checksum of data this path used to have is out of date
+	this->unbakedEntryMD5s.erase(finalEntry.path);
+	return finalEntry;
+}
+
+Entry& VPK::addPreparedEntry(Entry& entry, const std::string& filename_, bool saveToDirectory) {
+	auto filename = filename_;
+	if (!this->options.allowUppercaseLettersInFilenames) {
+		::toLowerCase(filename);
+	}
+	auto [dir, name] = ::splitFilenameAndParentDir(filename);
+
+	entry.path = filename;
+
+	// Offset will be reset when it's baked
+	entry.offset = 0;
+	entry.vpk_archiveIndex = saveToDirectory ? VPK_DIR_INDEX : this->numArchives;
+
 	// Now that archive index is calculated for this entry, check if it needs to be incremented
-	if (!options_.vpk_saveToDirectory) {
+	if (!saveToDirectory) {
 		entry.offset = this->currentlyFilledChunkSize;
-		this->currentlyFilledChunkSize += static_cast<int>(buffer.size());
+		this->currentlyFilledChunkSize += static_cast<int>(entry.length - entry.vpk_preloadedData.size());
 		if (this->options.vpk_preferredChunkSize) {
 			if (this->currentlyFilledChunkSize > this->options.vpk_preferredChunkSize) {
 				this->currentlyFilledChunkSize = 0;
@@ -334,11 +579,7 @@ Entry& VPK::addEntryInternal(Entry& entry, const std::string& filename_, std::ve
 		}
 	}
 
-	if (!this->unbakedEntries.contains(dir)) {
-		this->unbakedEntries[dir] = {};
-	}
-	this->unbakedEntries.at(dir).push_back(entry);
-	return this->unbakedEntries.at(dir).back();
+	return this->insertUnbakedEntry(dir, entry);
 }
 
 bool VPK::bake(const std::string& outputDir_, const Callback& callback) {
@@ -346,234 +587,437 @@ bool VPK::bake(const std::string& outputDir_, const Callback& callback) {
 	std::string outputDir = this->getBakeOutputDir(outputDir_);
 	std::string outputPath = outputDir + '/' + this->getFilename();
 
-    // Reconstruct data so we're not looping over it a ton of times
-    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<Entry*>>> temp;
+	// Reconstruct data so we're not looping over it a ton of times.
+	// Extensions, directories and files are sorted, so the same entries always bake to the same VPK
+	std::map<std::string, std::map<std::string, std::vector<Entry*>>> temp;
 
-    for (auto& [tDir, tEntries] : this->entries) {
-        for (auto& tEntry : tEntries) {
-	        std::string extension = tEntry.getExtension();
-	        if (extension.empty()) {
-		        extension = " ";
-	        }
-            if (!temp.contains(extension)) {
-                temp[extension] = {};
-            }
-            if (!temp.at(extension).contains(tDir)) {
-                temp.at(extension)[tDir] = {};
-            }
-            temp.at(extension).at(tDir).push_back(&tEntry);
-        }
-    }
-    for (auto& [tDir, tEntries]: this->unbakedEntries) {
-        for (auto& tEntry : tEntries) {
+	// Baked entries are stored compactly, pull them out so their offsets can be rewritten
+	auto bakedEntries = this->copyBakedEntries();
+	for (auto& tEntry : bakedEntries) {
+		std::string extension = tEntry.getExtension();
+		if (extension.empty()) {
+			extension = " ";
+		}
+		temp[extension][tEntry.getParentPath()].push_back(&tEntry);
+	}
+	for (auto& [tDir, tEntries] : this->unbakedEntries) {
+		for (auto& tEntry : tEntries) {
 			std::string extension = tEntry.getExtension();
 			if (extension.empty()) {
 				extension = " ";
 			}
-            if (!temp.contains(extension)) {
-                temp[extension] = {};
-            }
-            if (!temp.at(extension).contains(tDir)) {
-                temp.at(extension)[tDir] = {};
-            }
-            temp.at(extension).at(tDir).push_back(&tEntry);
-        }
-    }
+			temp[extension][tDir].push_back(&tEntry);
+		}
+	}
+	for (auto& [ext, tDirs] : temp) {
+		for (auto& [dir, tEntries] : tDirs) {
+			std::sort(tEntries.begin(), tEntries.end(), [](const Entry* lhs, const Entry* rhs) {
+				return lhs->path < rhs->path;
+			});
+		}
+	}
 
-    // Temporarily store baked file data that's stored in the directory VPK since it's getting overwritten
-    std::vector<std::byte> dirVPKEntryData;
-    std::size_t newDirEntryOffset = 0;
-    for (auto& [tDir, tEntries] : this->entries) {
-        for (Entry& tEntry : tEntries) {
-            if (!tEntry.unbaked && tEntry.vpk_archiveIndex == VPK_DIR_INDEX && tEntry.length != tEntry.vpk_preloadedData.size()) {
-                auto binData = this->readEntry(tEntry);
-                if (!binData) {
-                    continue;
-                }
-                dirVPKEntryData.reserve(dirVPKEntryData.size() + tEntry.length - tEntry.vpk_preloadedData.size());
-                dirVPKEntryData.insert(dirVPKEntryData.end(), binData->begin() + static_cast<std::vector<std::byte>::difference_type>(tEntry.vpk_preloadedData.size()), binData->end());
+	// Checksums of entries that are already baked are kept, so only new data has to be read back and hashed.
+	// They're matched up by where their data is, skipping any location shared by more than one entry.
+	// A baked and an unbaked entry can share a path, so the checksums belong to the entries themselves
+	std::unordered_map<const Entry*, std::array<std::byte, 16>> keptMD5s;
+	for (const auto& [tDir, tEntries] : this->unbakedEntries) {
+		for (const auto& tEntry : tEntries) {
+			if (auto unbakedMD5 = this->unbakedEntryMD5s.find(tEntry.path); unbakedMD5 != this->unbakedEntryMD5s.end()) {
+				keptMD5s[&tEntry] = unbakedMD5->second;
+			}
+		}
+	}
+	this->unbakedEntryMD5s.clear();
+	if (this->header1.version != 1 && this->options.vpk_generateMD5Entries && !this->md5Entries.empty()) {
+		using Location = std::tuple<std::uint32_t, std::uint64_t, std::uint64_t>;
+		std::map<Location, std::pair<const Entry*, int>> bakedEntryLocations;
+		for (const auto& tEntry : bakedEntries) {
+			auto& [locationEntry, count] = bakedEntryLocations[{tEntry.vpk_archiveIndex, tEntry.offset, tEntry.length - tEntry.vpk_preloadedData.size()}];
+			locationEntry = &tEntry;
+			count++;
+		}
+		for (const auto& md5Entry : this->md5Entries) {
+			auto location = bakedEntryLocations.find({md5Entry.archiveIndex, md5Entry.offset, md5Entry.length});
+			if (location != bakedEntryLocations.end() && location->second.second == 1) {
+				keptMD5s[location->second.first] = md5Entry.checksum;
+			}
+		}
+	}
 
-                tEntry.offset = newDirEntryOffset;
-                newDirEntryOffset += tEntry.length - tEntry.vpk_preloadedData.size();
-            }
-        }
-    }
+	// Lay out the data section of the directory VPK up front. The new directory VPK is written next to the old one,
+	// so data already stored in it can be copied over a chunk at a time instead of being held in memory
+	struct DirData {
+		Entry* entry;
+		/// Where the data is in the old directory VPK, for baked entries
+		std::uint64_t sourceOffset;
+	};
+	std::vector<DirData> dirData;
+	std::uint64_t dirDataSize = 0;
+	for (Entry& tEntry : bakedEntries) {
+		if (tEntry.vpk_archiveIndex == VPK_DIR_INDEX && tEntry.length != tEntry.vpk_preloadedData.size()) {
+			dirData.push_back({&tEntry, this->getEntryDataOffset(tEntry)});
+			tEntry.offset = dirDataSize;
+			dirDataSize += tEntry.length - tEntry.vpk_preloadedData.size();
+		}
+	}
+
+	// Unbaked data going into numbered archives is appended archive by archive, so each one is opened once
+	std::vector<Entry*> archiveData;
+	std::uint64_t treeSize = 1;
+	std::size_t entryCount = 0;
+	for (auto& [ext, tDirs] : temp) {
+		treeSize += ext.size() + 2;
+		for (auto& [dir, tEntries] : tDirs) {
+			treeSize += std::max<std::size_t>(dir.size(), 1) + 2;
+			for (auto* entry : tEntries) {
+				entryCount++;
+				treeSize += entry->getStem().size() + 1 + VPK_ENTRY_METADATA_SIZE + entry->vpk_preloadedData.size();
+				if (!entry->unbaked) {
+					continue;
+				}
+				if (entry->length == entry->vpk_preloadedData.size()) {
+					// Override the archive index, no need for an archive VPK
+					entry->vpk_archiveIndex = VPK_DIR_INDEX;
+					entry->offset = dirDataSize;
+				} else if (entry->vpk_archiveIndex != VPK_DIR_INDEX) {
+					archiveData.push_back(entry);
+				} else {
+					dirData.push_back({entry, 0});
+					entry->offset = dirDataSize;
+					dirDataSize += entry->length - entry->vpk_preloadedData.size();
+				}
+			}
+		}
+	}
+	std::stable_sort(archiveData.begin(), archiveData.end(), [](const Entry* lhs, const Entry* rhs) {
+		return lhs->vpk_archiveIndex < rhs->vpk_archiveIndex;
+	});
 
 	// Helper
 	const auto getArchiveFilename = [](const std::string& filename_, int archiveIndex) {
 		return filename_ + '_' + ::padArchiveIndex(archiveIndex) + VPK_EXTENSION.data();
 	};
 
-    // Copy external binary blobs to the new dir
-    if (!outputDir.empty()) {
-        for (int archiveIndex = 0; archiveIndex < this->numArchives; archiveIndex++) {
+	// Everything after this point may write to the files we have open
+	this->closeArchives();
+
+	// Copy external binary blobs to the new dir
+	if (!outputDir.empty()) {
+		// The archive being filled has an index of numArchives, and it might already have data
+		for (int archiveIndex = 0; archiveIndex <= this->numArchives; archiveIndex++) {
 			auto from = getArchiveFilename(this->getTruncatedFilepath(), archiveIndex);
-	        if (!std::filesystem::exists(from)) {
-		        continue;
-	        }
-	        std::string dest = getArchiveFilename(outputDir + '/' + this->getTruncatedFilestem(), archiveIndex);
+			if (!std::filesystem::exists(from)) {
+				continue;
+			}
+			std::string dest = getArchiveFilename(outputDir + '/' + this->getTruncatedFilestem(), archiveIndex);
 			if (from == dest) {
 				continue;
 			}
 			std::filesystem::copy_file(from, dest, std::filesystem::copy_options::overwrite_existing);
-        }
-    }
-
-    FileStream outDir{outputPath, FILESTREAM_OPT_READ | FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
-    outDir.seekInput(0);
-    outDir.seekOutput(0);
-
-	// Dummy header
-    outDir.write(this->header1);
-    if (this->header1.version == 2) {
-        outDir.write(this->header2);
-    }
+		}
+	}
 
-    // File tree data
-    for (auto& [ext, tDirs] : temp) {
-        outDir.write(ext);
-
-        for (auto& [dir, tEntries] : tDirs) {
-            outDir.write(!dir.empty() ? dir : " ");
-
-            for (auto* entry : tEntries) {
-                // Calculate entry offset if it's unbaked and upload the data
-                if (entry->unbaked) {
-                    std::vector<std::byte> entryData;
-					if (isEntryUnbakedUsingByteBuffer(*entry)) {
-						entryData = std::get<std::vector<std::byte>>(getEntryUnbakedData(*entry));
-					} else {
-						entryData = ::readFileData(std::get<std::string>(getEntryUnbakedData(*entry)), entry->vpk_preloadedData.size());
-					}
+	// Checksums are worked out from the data as it's written, only baked data that stays where it is gets read
+	const bool generateMD5Entries = this->header1.version != 1 && this->options.vpk_generateMD5Entries;
 
-                    if (entry->length == entry->vpk_preloadedData.size()) {
-                        // Override the archive index, no need for an archive VPK
-                        entry->vpk_archiveIndex = VPK_DIR_INDEX;
-                        entry->offset = dirVPKEntryData.size();
-                    } else if (entry->vpk_archiveIndex != VPK_DIR_INDEX) {
-						auto archiveFilename = getArchiveFilename(::removeVPKAndOrDirSuffix(outputPath), entry->vpk_archiveIndex);
-						entry->offset = std::filesystem::exists(archiveFilename) ? std::filesystem::file_size(archiveFilename) : 0;
-
-                        FileStream stream{archiveFilename, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_APPEND | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
-                        stream.writeBytes(entryData);
-                    } else {
-                        entry->offset = dirVPKEntryData.size();
-                        dirVPKEntryData.insert(dirVPKEntryData.end(), entryData.data(), entryData.data() + entryData.size());
-                    }
-                }
+	// Hand an unbaked entry's data (minus the preloaded bytes) to the consumer a chunk at a time
+	const auto readUnbakedData = [](const Entry& entry, std::vector<std::byte>& chunk, const auto& consume) {
+		if (isEntryUnbakedUsingByteBuffer(entry)) {
+			// Preloaded bytes were already taken out of the buffer
+			consume(std::span<const std::byte>{std::get<std::vector<std::byte>>(getEntryUnbakedData(entry))});
+			return true;
+		}
+		FileStream source{std::get<std::string>(getEntryUnbakedData(entry))};
+		if (!source) {
+			return false;
+		}
+		source.seekInput(entry.vpk_preloadedData.size());
+		for (std::uint64_t remaining = entry.length - entry.vpk_preloadedData.size(); remaining > 0;) {
+			auto toCopy = std::span{chunk}.first(std::min<std::uint64_t>(remaining, chunk.size()));
+			if (!source.readBytes(toCopy)) {
+				return false;
+			}
+			consume(std::span<const std::byte>{toCopy});
+			remaining -= toCopy.size();
+		}
+		return true;
+	};
 
-                outDir.write(entry->getStem());
-                outDir.write(entry->crc32);
-                outDir.write(static_cast<std::uint16_t>(entry->vpk_preloadedData.size()));
-                outDir.write(entry->vpk_archiveIndex);
-                outDir.write(static_cast<std::uint32_t>(entry->offset));
-                outDir.write(static_cast<std::uint32_t>(entry->length - entry->vpk_preloadedData.size()));
-                outDir.write(VPK_ENTRY_TERM);
+	// Progress is reported once an entry's data is where it belongs, which happens on several threads for the archives
+	std::mutex callbackMutex;
+	const auto reportBaked = [&callback, &callbackMutex](const Entry& entry) {
+		if (callback) {
+			std::scoped_lock lock{callbackMutex};
+			callback(entry.getParentPath(), entry);
+		}
+	};
 
-                if (!entry->vpk_preloadedData.empty()) {
-                    outDir.writeBytes(entry->vpk_preloadedData);
-                }
+	// Each archive getting new data is written on its own thread
+	std::vector<std::pair<std::size_t, std::size_t>> archiveRanges;
+	for (std::size_t archiveBegin = 0, archiveEnd; archiveBegin < archiveData.size(); archiveBegin = archiveEnd) {
+		for (archiveEnd = archiveBegin; archiveEnd < archiveData.size() && archiveData[archiveEnd]->vpk_archiveIndex == archiveData[archiveBegin]->vpk_archiveIndex; archiveEnd++) {}
+		archiveRanges.emplace_back(archiveBegin, archiveEnd);
+	}
+	const auto truncatedOutputPath = ::removeVPKAndOrDirSuffix(outputPath);
+	std::vector<std::array<std::byte, 16>> archiveDataMD5s(archiveData.size());
+	const bool archivesWritten = ::runInParallel(0, archiveRanges.size(), [&](std::size_t r, std::vector<std::byte>& chunk) {
+		chunk.resize(VPK_BAKE_CHUNK_SIZE);
+		const auto [archiveBegin, archiveEnd] = archiveRanges[r];
+		std::uint64_t appendSize = 0;
+		for (std::size_t i = archiveBegin; i < archiveEnd; i++) {
+			appendSize += archiveData[i]->length - archiveData[i]->vpk_preloadedData.size();
+		}
 
-				if (callback) {
-					callback(dir, *entry);
+		auto archiveFilename = getArchiveFilename(truncatedOutputPath, archiveData[archiveBegin]->vpk_archiveIndex);
+		std::uint64_t archiveSize = std::filesystem::exists(archiveFilename) ? std::filesystem::file_size(archiveFilename) : 0;
+		FileStream stream{archiveFilename, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_APPEND | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
+		if (!stream) {
+			return false;
+		}
+		::preallocateFile(archiveFilename, archiveSize, appendSize);
+		for (std::size_t i = archiveBegin; i < archiveEnd; i++) {
+			auto* entry = archiveData[i];
+			entry->offset = archiveSize;
+			const bool hash = generateMD5Entries && !keptMD5s.contains(entry);
+			MD5 entryMD5;
+			::updateMD5(entryMD5, entry->vpk_preloadedData);
+			if (!readUnbakedData(*entry, chunk, [hash, &stream, &entryMD5](std::span<const std::byte> data) {
+				stream.writeBytes(data);
+				if (hash) {
+					::updateMD5(entryMD5, data);
 				}
-            }
-            outDir.write('\0');
-        }
-        outDir.write('\0');
-    }
-    outDir.write('\0');
-
-    // Put files copied from the dir archive back
-    if (!dirVPKEntryData.empty()) {
-        outDir.writeBytes(dirVPKEntryData);
-    }
-
-    // Merge unbaked into baked entries
-	this->mergeUnbakedEntries();
+			}) || !stream) {
+				return false;
+			}
+			if (hash) {
+				archiveDataMD5s[i] = ::finalizeMD5(entryMD5);
+			}
+			archiveSize += entry->length - entry->vpk_preloadedData.size();
+			reportBaked(*entry);
+		}
+		return true;
+	}, ::stopOnFailure);
+	if (!archivesWritten) {
+		return false;
+	}
+	if (generateMD5Entries) {
+		for (std::size_t i = 0; i < archiveData.size(); i++) {
+			keptMD5s.try_emplace(archiveData[i], archiveDataMD5s[i]);
+		}
+	}
 
-    // Calculate Header1
-    this->header1.treeSize = outDir.tellOutput() - dirVPKEntryData.size() - this->getHeaderLength();
-
-    // VPK v2 stuff
-    if (this->header1.version != 1) {
-        // Calculate hashes for all entries
-        this->md5Entries.clear();
-		if (this->options.vpk_generateMD5Entries) {
-			for (const auto& [tDir, tEntries] : this->entries) {
-				for (const auto& tEntry : tEntries) {
-					// Believe it or not this should be safe to call by now
-					auto binData = this->readEntry(tEntry);
-					if (!binData) {
-						continue;
-					}
-					MD5Entry md5Entry{};
-					md5Entry.archiveIndex = tEntry.vpk_archiveIndex;
-					md5Entry.length = tEntry.length - tEntry.vpk_preloadedData.size();
-					md5Entry.offset = tEntry.offset;
-					md5Entry.checksum = md5(*binData);
-					this->md5Entries.push_back(md5Entry);
+	// Baked data in the numbered archives stays where it is, anything there without a checksum yet is read and hashed
+	if (generateMD5Entries) {
+		std::vector<const Entry*> toHash;
+		for (const auto& tEntry : bakedEntries) {
+			if (tEntry.vpk_archiveIndex != VPK_DIR_INDEX && !keptMD5s.contains(&tEntry)) {
+				toHash.push_back(&tEntry);
+			}
+		}
+		std::sort(toHash.begin(), toHash.end(), [](const Entry* lhs, const Entry* rhs) {
+			return std::tie(lhs->vpk_archiveIndex, lhs->offset) < std::tie(rhs->vpk_archiveIndex, rhs->offset);
+		});
+
+		std::vector<std::array<std::byte, 16>> hashedMD5s(toHash.size());
+		const bool allHashed = ::runInParallel(0, toHash.size(), [&](std::size_t i, std::vector<std::byte>& chunk) {
+			chunk.resize(VPK_BAKE_CHUNK_SIZE);
+			const auto& entry = *toHash[i];
+			MD5 entryMD5;
+			::updateMD5(entryMD5, entry.vpk_preloadedData);
+			for (std::uint64_t hashed = 0, length = entry.length - entry.vpk_preloadedData.size(); hashed < length;) {
+				auto toRead = std::span{chunk}.first(std::min<std::uint64_t>(length - hashed, chunk.size()));
+				if (!this->readArchiveInto(entry.vpk_archiveIndex, this->getEntryDataOffset(entry) + hashed, toRead)) {
+					return false;
 				}
+				::updateMD5(entryMD5, toRead);
+				hashed += toRead.size();
 			}
+			hashedMD5s[i] = ::finalizeMD5(entryMD5);
+			return true;
+		}, ::stopOnFailure);
+		if (!allHashed) {
+			return false;
 		}
+		for (std::size_t i = 0; i < toHash.size(); i++) {
+			keptMD5s[toHash[i]] = hashedMD5s[i];
+		}
+	}
 
-        // Calculate Header2
-        this->header2.fileDataSectionSize = dirVPKEntryData.size();
-        this->header2.archiveMD5SectionSize = this->md5Entries.size() * sizeof(MD5Entry);
-        this->header2.otherMD5SectionSize = 48;
-        this->header2.signatureSectionSize = 0;
+	// The headers already have their final values, so the whole file can be hashed as it's written
+	this->header1.treeSize = treeSize;
+	if (this->header1.version == 2) {
+		this->header2.fileDataSectionSize = dirDataSize;
+		this->header2.archiveMD5SectionSize = generateMD5Entries ? entryCount * sizeof(MD5Entry) : 0;
+		this->header2.otherMD5SectionSize = 48;
+		this->header2.signatureSectionSize = 0;
+	}
+	const std::uint64_t outputSize = this->getHeaderLength() + treeSize + dirDataSize + (this->header1.version == 2 ? this->header2.archiveMD5SectionSize + this->header2.otherMD5SectionSize : 0);
 
-        // Calculate Footer2
-        MD5 wholeFileChecksumMD5;
-        {
-            // Only the tree is updated in the file right now
-            wholeFileChecksumMD5.update(reinterpret_cast<const std::byte*>(&this->header1), sizeof(Header1));
-            wholeFileChecksumMD5.update(reinterpret_cast<const std::byte*>(&this->header2), sizeof(Header2));
-        }
-        {
-            outDir.seekInput(sizeof(Header1) + sizeof(Header2));
-            std::vector<std::byte> treeData = outDir.readBytes(this->header1.treeSize);
-            wholeFileChecksumMD5.update(treeData.data(), treeData.size());
-            this->footer2.treeChecksum = md5(treeData);
-        }
-        if (!dirVPKEntryData.empty()) {
-            wholeFileChecksumMD5.update(dirVPKEntryData.data(), dirVPKEntryData.size());
-        }
-        {
-            wholeFileChecksumMD5.update(reinterpret_cast<const std::byte*>(this->md5Entries.data()), this->md5Entries.size() * sizeof(MD5Entry));
-            MD5 md5EntriesChecksumMD5;
-            md5EntriesChecksumMD5.update(reinterpret_cast<const std::byte*>(this->md5Entries.data()), this->md5Entries.size() * sizeof(MD5Entry));
-            md5EntriesChecksumMD5.finalize(reinterpret_cast<unsigned char*>(this->footer2.md5EntriesChecksum.data()));
-        }
-        wholeFileChecksumMD5.finalize(reinterpret_cast<unsigned char*>(this->footer2.wholeFileChecksum.data()));
+	// Write to a temporary file while the old directory VPK is still being read from
+	const auto tempOutputPath = outputPath + ".tmp";
+	bool success = true;
+	{
+		FileStream outDir{tempOutputPath, FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE | FILESTREAM_OPT_CREATE_IF_NONEXISTENT};
+		::preallocateFile(tempOutputPath, 0, outputSize);
+
+		MD5 wholeFileMD5;
+		const auto writeHashed = [this, &outDir, &wholeFileMD5](std::span<const std::byte> data) {
+			outDir.writeBytes(data);
+			if (this->header1.version == 2) {
+				::updateMD5(wholeFileMD5, data);
+			}
+		};
 
-        // We can't recalculate the signature without the private key
-        this->footer2.publicKey.clear();
-        this->footer2.signature.clear();
-    }
+		writeHashed(std::as_bytes(std::span{&this->header1, 1}));
+		if (this->header1.version == 2) {
+			writeHashed(std::as_bytes(std::span{&this->header2, 1}));
+		}
 
-    // Write new headers
-    outDir.seekOutput(0);
-    outDir.write(this->header1);
+		// File tree data, put together in memory so it can be hashed without reading it back
+		std::vector<std::byte> tree;
+		tree.reserve(treeSize);
+		const auto appendToTree = [&tree](const auto& value) {
+			auto bytes = std::as_bytes(std::span{&value, 1});
+			tree.insert(tree.end(), bytes.begin(), bytes.end());
+		};
+		const auto appendStringToTree = [&tree](std::string_view str) {
+			auto bytes = std::as_bytes(std::span{str});
+			tree.insert(tree.end(), bytes.begin(), bytes.end());
+			tree.push_back(std::byte{0});
+		};
+		for (auto& [ext, tDirs] : temp) {
+			appendStringToTree(ext);
+
+			for (auto& [dir, tEntries] : tDirs) {
+				appendStringToTree(!dir.empty() ? dir : " ");
+
+				for (auto* entry : tEntries) {
+					appendStringToTree(entry->getStem());
+					appendToTree(entry->crc32);
+					appendToTree(static_cast<std::uint16_t>(entry->vpk_preloadedData.size()));
+					appendToTree(entry->vpk_archiveIndex);
+					appendToTree(static_cast<std::uint32_t>(entry->offset));
+					appendToTree(static_cast<std::uint32_t>(entry->length - entry->vpk_preloadedData.size()));
+					appendToTree(VPK_ENTRY_TERM);
+					tree.insert(tree.end(), entry->vpk_preloadedData.begin(), entry->vpk_preloadedData.end());
+
+					// Entries with data in the directory VPK are reported once it's copied over, and new data going
+					// into numbered archives has been written already
+					if (entry->length == entry->vpk_preloadedData.size() || (!entry->unbaked && entry->vpk_archiveIndex != VPK_DIR_INDEX)) {
+						reportBaked(*entry);
+					}
+				}
+				tree.push_back(std::byte{0});
+			}
+			tree.push_back(std::byte{0});
+		}
+		tree.push_back(std::byte{0});
+		success = tree.size() == treeSize;
+		writeHashed(tree);
+		if (this->header1.version == 2) {
+			this->footer2.treeChecksum = md5(tree);
+		}
 
-    // v2 adds the MD5 hashes and file signature
-    if (this->header1.version < 2) {
-	    PackFile::setFullFilePath(outputDir);
-        return true;
-    }
+		// Put files copied from the dir archive back
+		std::vector<std::byte> chunk(VPK_BAKE_CHUNK_SIZE);
+		for (std::size_t i = 0; success && i < dirData.size(); i++) {
+			const auto& [entry, sourceOffset] = dirData[i];
+			const bool hash = generateMD5Entries && !keptMD5s.contains(entry);
+			MD5 entryMD5;
+			::updateMD5(entryMD5, entry->vpk_preloadedData);
+			const auto consume = [hash, &entryMD5, &writeHashed](std::span<const std::byte> data) {
+				writeHashed(data);
+				if (hash) {
+					::updateMD5(entryMD5, data);
+				}
+			};
+			if (entry->unbaked) {
+				success = readUnbakedData(*entry, chunk, consume);
+			} else {
+				for (std::uint64_t copied = 0, length = entry->length - entry->vpk_preloadedData.size(); success && copied < length;) {
+					auto toCopy = std::span{chunk}.first(std::min<std::uint64_t>(length - copied, chunk.size()));
+					success = this->readArchiveInto(VPK_DIR_INDEX, sourceOffset + copied, toCopy);
+					consume(toCopy);
+					copied += toCopy.size();
+				}
+			}
+			if (hash) {
+				keptMD5s[entry] = ::finalizeMD5(entryMD5);
+			}
+			if (success) {
+				reportBaked(*entry);
+			}
+		}
 
-    outDir.write(this->header2);
+		// VPK v2 stuff
+		if (success && this->header1.version == 2) {
+			this->md5Entries.clear();
+			if (generateMD5Entries) {
+				this->md5Entries.reserve(entryCount);
+				for (auto& [ext, tDirs] : temp) {
+					for (auto& [dir, tEntries] : tDirs) {
+						for (const auto* entry : tEntries) {
+							MD5Entry md5Entry{};
+							md5Entry.archiveIndex = entry->vpk_archiveIndex;
+							md5Entry.length = entry->length - entry->vpk_preloadedData.size();
+							md5Entry.offset = entry->offset;
+							if (auto keptMD5 = keptMD5s.find(entry); keptMD5 != keptMD5s.end()) {
+								md5Entry.checksum = keptMD5->second;
+							} else {
+								// Only entries that are entirely preloaded have nothing written anywhere
+								md5Entry.checksum = md5(entry->vpk_preloadedData);
+							}
+							this->md5Entries.push_back(md5Entry);
+						}
+					}
+				}
+				std::sort(this->md5Entries.begin(), this->md5Entries.end(), [](const MD5Entry& lhs, const MD5Entry& rhs) {
+					// Fields are compared by value, they're packed
+					return std::make_tuple(lhs.archiveIndex, lhs.offset, lhs.length, lhs.checksum) < std::make_tuple(rhs.archiveIndex, rhs.offset, rhs.length, rhs.checksum);
+				});
+			}
+			auto md5Section = std::as_bytes(std::span{this->md5Entries});
+			writeHashed(md5Section);
+			MD5 md5EntriesChecksumMD5;
+			::updateMD5(md5EntriesChecksumMD5, md5Section);
+			this->footer2.md5EntriesChecksum = ::finalizeMD5(md5EntriesChecksumMD5);
+
+			// The whole file checksum covers everything before it, including the other two checksums
+			writeHashed(this->footer2.treeChecksum);
+			writeHashed(this->footer2.md5EntriesChecksum);
+			this->footer2.wholeFileChecksum = ::finalizeMD5(wholeFileMD5);
+			outDir.writeBytes(this->footer2.wholeFileChecksum);
+
+			// We can't recalculate the signature without the private key
+			this->footer2.publicKey.clear();
+			this->footer2.signature.clear();
+		}
+		outDir.flush();
+		success &= static_cast<bool>(outDir) && outDir.tellOutput() == outputSize;
+	}
 
-    // Add MD5 hashes
-    outDir.seekOutput(sizeof(Header1) + sizeof(Header2) + this->header1.treeSize + dirVPKEntryData.size());
-    outDir.write(this->md5Entries);
-    outDir.writeBytes(this->footer2.treeChecksum);
-    outDir.writeBytes(this->footer2.md5EntriesChecksum);
-    outDir.writeBytes(this->footer2.wholeFileChecksum);
+	// The old directory VPK can go now
+	this->closeArchives();
+	std::error_code ec;
+	if (success) {
+		std::filesystem::rename(tempOutputPath, outputPath, ec);
+	}
+	if (!success || ec) {
+		std::filesystem::remove(tempOutputPath, ec);
+		return false;
+	}
 
-    // The signature section is not present
+	// Merge unbaked into baked entries
+	this->entries.clear();
+	for (const auto& tEntry : bakedEntries) {
+		this->insertBakedEntry(tEntry);
+	}
+	this->mergeUnbakedEntries();
 	PackFile::setFullFilePath(outputDir);
-    return true;
+
+	// The signature section is not present
+	return true;
 }
 
 std::string VPK::getTruncatedFilestem() const {
@@ -602,6 +1046,85 @@ void VPK::setVersion(std::uint32_t version) {
     this->md5Entries.clear();
 }
 
+bool VPK::readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
+	// Preloaded data goes first, the rest is stored in an archive
+	const std::uint64_t preloadedLength = entry.vpk_preloadedData.size();
+	if (offset < preloadedLength) {
+		auto preloadedData = std::span{entry.vpk_preloadedData}.subspan(offset, std::min<std::uint64_t>(preloadedLength - offset, buffer.size()));
+		std::copy(preloadedData.begin(), preloadedData.end(), buffer.begin());
+		buffer = buffer.subspan(preloadedData.size());
+		offset = 0;
+	} else {
+		offset -= preloadedLength;
+	}
+	if (buffer.empty()) {
+		return true;
+	}
+
+	// Offset is now relative to the start of the archive data
+	if (entry.unbaked) {
+		// Files on disk still start with the preloaded bytes, buffers had them removed in addEntryInternal
+		return this->readUnbakedEntryInto(entry, (isEntryUnbakedUsingByteBuffer(entry) ? 0 : preloadedLength) + offset, buffer);
+	}
+	return this->readArchiveInto(entry.vpk_archiveIndex, this->getEntryDataOffset(entry) + offset, buffer);
+}
+
+std::optional<PackFile::EntryDataLocation> VPK::getEntryDataLocation(const Entry& entry) const {
+	if (entry.unbaked) {
+		return std::nullopt;
+	}
+	return EntryDataLocation{entry.vpk_archiveIndex, this->getEntryDataOffset(entry), entry.vpk_preloadedData};
+}
+
+std::string VPK::getArchiveFilepath(std::uint16_t archiveIndex) const {
+	if (archiveIndex == VPK_DIR_INDEX) {
+		return this->fullFilePath;
+	}
+	return this->getTruncatedFilepath() + '_' + ::padArchiveIndex(archiveIndex) + VPK_EXTENSION.data();
+}
+
+std::uint64_t VPK::getEntryDataOffset(const Entry& entry) const {
+	// Data in the directory VPK is stored right after the file tree
+	return (entry.vpk_archiveIndex == VPK_DIR_INDEX ? this->getHeaderLength() + this->header1.treeSize : 0) + entry.offset;
+}
+
+bool VPK::verifyMD5Entries() const {
+	// An MD5 entry covers a range of an archive, but the ones made for entries with preloaded data here
+	// hash the preloaded bytes first, so those need to be known too. Entirely preloaded entries share a location
+	std::map<std::tuple<std::uint32_t, std::uint64_t, std::uint64_t>, std::vector<std::vector<std::byte>>> preloadedData;
+	this->runForAllEntries([&preloadedData](const std::string&, const Entry& entry) {
+		if (!entry.vpk_preloadedData.empty()) {
+			preloadedData[{entry.vpk_archiveIndex, entry.offset, entry.length - entry.vpk_preloadedData.size()}].push_back(entry.vpk_preloadedData);
+		}
+	}, false);
+
+	return ::runInParallel(0, this->md5Entries.size(), [this, &preloadedData](std::size_t i, std::vector<std::byte>& chunk) {
+		chunk.resize(VPK_BAKE_CHUNK_SIZE);
+		const auto& md5Entry = this->md5Entries[i];
+		const auto archiveIndex = static_cast<std::uint16_t>(md5Entry.archiveIndex);
+		const std::uint64_t offset = md5Entry.offset + (archiveIndex == VPK_DIR_INDEX ? this->getHeaderLength() + this->header1.treeSize : 0);
+
+		// Hash the range on its own and with each possible set of preloaded bytes in front, in one pass
+		std::vector<MD5> md5s(1);
+		if (auto preloaded = preloadedData.find({md5Entry.archiveIndex, md5Entry.offset, md5Entry.length}); preloaded != preloadedData.end()) {
+			for (const auto& data : preloaded->second) {
+				::updateMD5(md5s.emplace_back(), data);
+			}
+		}
+		for (std::uint64_t hashed = 0; hashed < md5Entry.length;) {
+			auto toHash = std::span{chunk}.first(std::min<std::uint64_t>(md5Entry.length - hashed, chunk.size()));
+			if (!this->readArchiveInto(archiveIndex, offset + hashed, toHash)) {
+				return false;
+			}
+			for (auto& hash : md5s) {
+				::updateMD5(hash, toHash);
+			}
+			hashed += toHash.size();
+		}
+		return std::any_of(md5s.begin(), md5s.end(), [&md5Entry](MD5& hash) { return ::finalizeMD5(hash) == md5Entry.checksum; });
+	}, ::stopOnFailure);
+}
+
 std::uint32_t VPK::getHeaderLength() const {
 	if (this->header1.version < 2) {
 		return sizeof(Header1);
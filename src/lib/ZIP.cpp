@@ -1,5 +1,7 @@
 #include <vpkedit/ZIP.h>
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <filesystem>
 
@@ -14,6 +16,124 @@
 using namespace vpkedit;
 using namespace vpkedit::detail;
 
+/// A minizip handle of its own, so it can decode entries without disturbing anyone else reading from the ZIP
+class vpkedit::detail::ZIPReader {
+public:
+	ZIPReader() = default;
+	ZIPReader(const ZIPReader& other) = delete;
+	ZIPReader& operator=(const ZIPReader& other) = delete;
+
+	~ZIPReader() {
+		this->closeEntry();
+		if (this->zipOpen) {
+			mz_zip_close(this->zipHandle);
+			mz_zip_delete(&this->zipHandle);
+		}
+		if (this->streamOpen) {
+			mz_stream_os_close(this->streamHandle);
+			mz_stream_os_delete(&this->streamHandle);
+		}
+	}
+
+	bool open(const std::string& zipPath) {
+		this->streamHandle = mz_stream_os_create();
+		if (mz_stream_os_open(this->streamHandle, zipPath.c_str(), MZ_OPEN_MODE_READ) != MZ_OK) {
+			return false;
+		}
+		this->streamOpen = true;
+
+		this->zipHandle = mz_zip_create();
+		if (mz_zip_open(this->zipHandle, this->streamHandle, MZ_OPEN_MODE_READ) != MZ_OK) {
+			return false;
+		}
+		this->zipOpen = true;
+		return true;
+	}
+
+	/// Start decoding an entry from its beginning
+	bool openEntry(const std::string& entryPath, bool ignoreCase) {
+		this->closeEntry();
+		if (mz_zip_locate_entry(this->zipHandle, entryPath.c_str(), ignoreCase) != MZ_OK) {
+			return false;
+		}
+		return this->rewind();
+	}
+
+	/// Compressed data can't be seeked, start over to go backwards and decode and throw away data to go forwards
+	bool seek(std::uint64_t position) {
+		if (position < this->decodedPosition && !this->rewind()) {
+			return false;
+		}
+		std::array<std::byte, 0x2000> scratch; // NOLINT(*-member-init)
+		while (this->decodedPosition < position) {
+			if (!this->read(std::span{scratch}.first(static_cast<std::size_t>(std::min<std::uint64_t>(scratch.size(), position - this->decodedPosition))))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool read(std::span<std::byte> buffer) {
+		// minizip reads at most INT32_MAX bytes at a time
+		while (!buffer.empty()) {
+			auto toRead = static_cast<std::int32_t>(std::min<std::uint64_t>(buffer.size(), INT32_MAX));
+			auto bytesRead = mz_zip_entry_read(this->zipHandle, buffer.data(), toRead);
+			if (bytesRead <= 0) {
+				return false;
+			}
+			buffer = buffer.subspan(bytesRead);
+			this->decodedPosition += bytesRead;
+		}
+		return true;
+	}
+
+	void closeEntry() {
+		if (this->entryOpen) {
+			mz_zip_entry_close(this->zipHandle);
+			this->entryOpen = false;
+		}
+	}
+
+private:
+	bool rewind() {
+		this->closeEntry();
+		if (mz_zip_entry_read_open(this->zipHandle, 0, nullptr) != MZ_OK) {
+			return false;
+		}
+		this->entryOpen = true;
+		this->decodedPosition = 0;
+		return true;
+	}
+
+	void* streamHandle = nullptr;
+	bool streamOpen = false;
+
+	void* zipHandle = nullptr;
+	bool zipOpen = false;
+
+	bool entryOpen = false;
+	std::uint64_t decodedPosition = 0;
+};
+
+namespace {
+
+/// Compressed entries are decoded sequentially by a reader of their own
+class ZIPEntryReader : public EntryReader {
+public:
+	ZIPEntryReader(std::uint64_t length_, std::unique_ptr<ZIPReader> reader_)
+			: EntryReader(length_)
+			, reader(std::move(reader_)) {}
+
+protected:
+	bool readInternal(std::span<std::byte> buffer) override {
+		return this->reader->seek(this->position) && this->reader->read(buffer);
+	}
+
+	std::unique_ptr<ZIPReader> reader;
+};
+
+} // namespace
+
 const std::string ZIP::TEMP_ZIP_PATH = (std::filesystem::temp_directory_path() / "tmp.zip").string();
 
 ZIP::ZIP(const std::string& fullFilePath_, PackFileOptions options_)
@@ -34,82 +154,116 @@ std::unique_ptr<PackFile> ZIP::open(const std::string& path, PackFileOptions opt
 	auto* zip = new ZIP{path, options};
 	auto packFile = std::unique_ptr<PackFile>(zip);
 
-	if (!zip->openZIP(zip->fullFilePath)) {
+	if (!zip->openZIP(zip->fullFilePath) || !zip->loadEntries(callback)) {
 		return nullptr;
 	}
+	return packFile;
+}
 
-	for (auto code = mz_zip_goto_first_entry(zip->zipHandle); code == MZ_OK; code = mz_zip_goto_next_entry(zip->zipHandle)) {
-		mz_zip_file* fileInfo = nullptr;
-		if (mz_zip_entry_get_info(zip->zipHandle, &fileInfo)) {
-			return nullptr;
-		}
-		if (mz_zip_entry_is_dir(zip->zipHandle) == MZ_OK) {
-			continue;
-		}
+std::optional<std::vector<std::byte>> ZIP::readEntry(const Entry& entry) const {
+	std::vector<std::byte> out(entry.length);
+	if (!this->readEntryRangeInternal(entry, 0, out)) {
+		return std::nullopt;
+	}
+	return out;
+}
 
-		Entry entry = createNewEntry();
-		entry.path = fileInfo->filename;
-		::normalizeSlashes(entry.path);
-		if (!options.allowUppercaseLettersInFilenames) {
-			::toLowerCase(entry.path);
+std::optional<EntryView> ZIP::readEntryView(const Entry& entry) const {
+	if (!entry.unbaked) {
+		if (auto data = this->getStoredEntryData(entry)) {
+			return EntryView{*data};
 		}
+	}
+	// Compressed data has to be inflated somewhere
+	return PackFile::readEntryView(entry);
+}
 
-		entry.length = fileInfo->uncompressed_size;
-		entry.compressedLength = fileInfo->compressed_size;
-		entry.crc32 = fileInfo->crc;
-		entry.zip_compressionMethod = fileInfo->compression_method;
+std::unique_ptr<EntryReader> ZIP::openEntryStream(const Entry& entry) const {
+	if (entry.unbaked || this->getStoredEntryData(entry)) {
+		// Ranged reads are cheap for these
+		return PackFile::openEntryStream(entry);
+	}
+	auto reader = std::make_unique<ZIPReader>();
+	if (!reader->open(this->zipPath) || !reader->openEntry(entry.path, !this->options.allowUppercaseLettersInFilenames)) {
+		return nullptr;
+	}
+	return std::make_unique<ZIPEntryReader>(entry.length, std::move(reader));
+}
 
-		auto parentDir = std::filesystem::path(entry.path).parent_path().string();
-		::normalizeSlashes(parentDir);
-		if (!options.allowUppercaseLettersInFilenames) {
-			::toLowerCase(parentDir);
+std::vector<std::string> ZIP::verifyEntryChecksums(VerifyOptions options, const VerifyCallback& callback) const {
+	std::vector<Entry> entries;
+	this->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+		entries.push_back(entry);
+	}, false);
+
+	// Go through the local file headers from front to back, so the threads read close to each other
+	std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return lhs.offset < rhs.offset;
+	});
+
+	const auto bufferSize = std::max<std::size_t>(options.bufferSize, 4096);
+	return this->verifyEntriesInParallel(entries, [this, bufferSize](const Entry& entry, std::vector<std::byte>& buffer) {
+		if (entry.length == 0) {
+			return entry.crc32 == 0;
 		}
-		if (!zip->entries.contains(parentDir)) {
-			zip->entries[parentDir] = {};
+		if (auto data = this->getStoredEntryData(entry)) {
+			return ::computeCRC32(data->data(), data->size()) == entry.crc32;
 		}
-		zip->entries[parentDir].push_back(entry);
 
-		if (callback) {
-			callback(parentDir, entry);
+		// Compressed entries are decoded a chunk at a time, never all at once
+		auto reader = this->acquireZIPReader();
+		if (!reader) {
+			return false;
 		}
-	}
-
-	return packFile;
+		std::uint32_t crc32 = 0;
+		bool success = reader->openEntry(entry.path, !this->options.allowUppercaseLettersInFilenames);
+		buffer.resize(std::min<std::uint64_t>(entry.length, bufferSize));
+		for (std::uint64_t done = 0; success && done < entry.length;) {
+			auto chunk = std::span{buffer}.first(std::min<std::uint64_t>(entry.length - done, buffer.size()));
+			success = reader->read(chunk);
+			crc32 = ::computeCRC32(chunk.data(), chunk.size(), crc32);
+			done += chunk.size();
+		}
+		reader->closeEntry();
+		this->releaseZIPReader(std::move(reader));
+		return success && crc32 == entry.crc32;
+	}, options, callback);
 }
 
-std::optional<std::vector<std::byte>> ZIP::readEntry(const Entry& entry) const {
+bool ZIP::readEntryRangeInternal(const Entry& entry, std::uint64_t offset, std::span<std::byte> buffer) const {
 	if (entry.unbaked) {
-		// Get the stored data
-		for (const auto& [unbakedEntryDir, unbakedEntryList] : this->unbakedEntries) {
-			for (const Entry& unbakedEntry : unbakedEntryList) {
-				if (unbakedEntry.path == entry.path) {
-					std::vector<std::byte> unbakedData;
-					if (isEntryUnbakedUsingByteBuffer(unbakedEntry)) {
-						unbakedData = std::get<std::vector<std::byte>>(getEntryUnbakedData(unbakedEntry));
-					} else {
-						unbakedData = ::readFileData(std::get<std::string>(getEntryUnbakedData(unbakedEntry)));
-					}
-					return unbakedData;
-				}
-			}
-		}
-		return std::nullopt;
+		return this->readUnbakedEntryInto(entry, offset, buffer);
 	}
-	// It's baked into the file on disk
-	if (!this->streamOpen || !this->zipOpen) {
-		return std::nullopt;
+	if (auto data = this->getStoredEntryData(entry)) {
+		auto range = data->subspan(offset, buffer.size());
+		std::copy(range.begin(), range.end(), buffer.begin());
+		return true;
 	}
-	if (mz_zip_locate_entry(this->zipHandle, entry.path.c_str(), !this->options.allowUppercaseLettersInFilenames) != MZ_OK) {
+	if (buffer.empty()) {
+		return true;
+	}
+
+	// It's baked into the file on disk, borrow a reader so other threads can decode at the same time
+	auto reader = this->acquireZIPReader();
+	if (!reader) {
+		return false;
+	}
+	bool success = reader->openEntry(entry.path, !this->options.allowUppercaseLettersInFilenames) && reader->seek(offset) && reader->read(buffer);
+	reader->closeEntry();
+	this->releaseZIPReader(std::move(reader));
+	return success;
+}
+
+std::optional<PackFile::EntryDataLocation> ZIP::getEntryDataLocation(const Entry& entry) const {
+	if (entry.unbaked) {
 		return std::nullopt;
 	}
-	if (mz_zip_entry_read_open(this->zipHandle, 0, nullptr) != MZ_OK) {
+	// Only stored entries can be read straight from the file
+	auto data = this->getStoredEntryData(entry);
+	if (!data) {
 		return std::nullopt;
 	}
-	std::vector<std::byte> out;
-	out.resize(entry.length);
-	mz_zip_entry_read(this->zipHandle, out.data(), static_cast<int>(entry.length));
-	mz_zip_entry_close(this->zipHandle);
-	return out;
+	return EntryDataLocation{0, static_cast<std::uint64_t>(data->data() - this->getMappedArchive(0)->span().data()), {}};
 }
 
 Entry& ZIP::addEntryInternal(Entry& entry, const std::string& filename_, std::vector<std::byte>& buffer, EntryOptions options_) {
@@ -125,11 +279,7 @@ Entry& ZIP::addEntryInternal(Entry& entry, const std::string& filename_, std::ve
 	entry.crc32 = ::computeCRC32(buffer);
 	entry.zip_compressionMethod = options_.zip_compressionMethod;
 
-	if (!this->unbakedEntries.contains(dir)) {
-		this->unbakedEntries[dir] = {};
-	}
-	this->unbakedEntries.at(dir).push_back(entry);
-	return this->unbakedEntries.at(dir).back();
+	return this->insertUnbakedEntry(dir, entry);
 }
 
 bool ZIP::bake(const std::string& outputDir_, const Callback& callback) {
@@ -145,12 +295,16 @@ bool ZIP::bake(const std::string& outputDir_, const Callback& callback) {
 
 	// Close our ZIP and reopen it
 	this->closeZIP();
+	this->closeArchives();
 	std::filesystem::rename(ZIP::TEMP_ZIP_PATH, outputPath);
 	if (!this->openZIP(outputPath)) {
 		return false;
 	}
 	PackFile::setFullFilePath(outputDir);
-	return true;
+
+	// Entry offsets have all changed
+	this->entries.clear();
+	return this->loadEntries(nullptr);
 }
 
 bool ZIP::bakeTempZip(const std::string& writeZipPath, const Callback& callback) {
@@ -164,30 +318,36 @@ bool ZIP::bakeTempZip(const std::string& writeZipPath, const Callback& callback)
 		return false;
 	}
 
-	for (const auto& [entryDir, entries] : this->getBakedEntries()) {
-		for (const Entry& entry : entries) {
-			auto binData = this->readEntry(entry);
-			if (!binData) {
-				continue;
-			}
+	bool failedToWrite = false;
+	this->runForAllEntries([this, &callback, writeZipHandle, &failedToWrite](const std::string& entryDir, const Entry& entry) {
+		if (failedToWrite) {
+			return;
+		}
+		auto binData = this->readEntry(entry);
+		if (!binData) {
+			return;
+		}
 
-			mz_zip_file fileInfo;
-			std::memset(&fileInfo, 0, sizeof(mz_zip_entry));
-			fileInfo.flag = MZ_ZIP_FLAG_DATA_DESCRIPTOR;
-			fileInfo.filename = entry.path.c_str();
-			fileInfo.filename_size = entry.path.length();
-			fileInfo.uncompressed_size = static_cast<std::int64_t>(entry.length);
-			fileInfo.compressed_size = static_cast<std::int64_t>(entry.compressedLength);
-			fileInfo.crc = entry.crc32;
-			fileInfo.compression_method = entry.zip_compressionMethod;
-			if (mz_zip_writer_add_buffer(writeZipHandle, binData->data(), static_cast<int>(binData->size()), &fileInfo)) {
-				return false;
-			}
+		mz_zip_file fileInfo;
+		std::memset(&fileInfo, 0, sizeof(mz_zip_entry));
+		fileInfo.flag = MZ_ZIP_FLAG_DATA_DESCRIPTOR;
+		fileInfo.filename = entry.path.c_str();
+		fileInfo.filename_size = entry.path.length();
+		fileInfo.uncompressed_size = static_cast<std::int64_t>(entry.length);
+		fileInfo.compressed_size = static_cast<std::int64_t>(entry.compressedLength);
+		fileInfo.crc = entry.crc32;
+		fileInfo.compression_method = entry.zip_compressionMethod;
+		if (mz_zip_writer_add_buffer(writeZipHandle, binData->data(), static_cast<int>(binData->size()), &fileInfo)) {
+			failedToWrite = true;
+			return;
+		}
 
-			if (callback) {
-				callback(entry.getParentPath(), entry);
-			}
+		if (callback) {
+			callback(entryDir, entry);
 		}
+	}, false);
+	if (failedToWrite) {
+		return false;
 	}
 	for (const auto& [entryDir, entries] : this->getUnbakedEntries()) {
 		for (const Entry& entry : entries) {
@@ -227,6 +387,101 @@ bool ZIP::bakeTempZip(const std::string& writeZipPath, const Callback& callback)
 	return true;
 }
 
+bool ZIP::loadEntries(const Callback& callback) {
+	for (auto code = mz_zip_goto_first_entry(this->zipHandle); code == MZ_OK; code = mz_zip_goto_next_entry(this->zipHandle)) {
+		mz_zip_file* fileInfo = nullptr;
+		if (mz_zip_entry_get_info(this->zipHandle, &fileInfo)) {
+			return false;
+		}
+		if (mz_zip_entry_is_dir(this->zipHandle) == MZ_OK) {
+			continue;
+		}
+
+		Entry entry = createNewEntry();
+		entry.path = fileInfo->filename;
+		::normalizeSlashes(entry.path);
+		if (!this->options.allowUppercaseLettersInFilenames) {
+			::toLowerCase(entry.path);
+		}
+
+		entry.length = fileInfo->uncompressed_size;
+		entry.offset = fileInfo->disk_offset;
+		entry.compressedLength = fileInfo->compressed_size;
+		entry.crc32 = fileInfo->crc;
+		entry.zip_compressionMethod = fileInfo->compression_method;
+
+		auto parentDir = std::filesystem::path(entry.path).parent_path().string();
+		::normalizeSlashes(parentDir);
+		if (!this->options.allowUppercaseLettersInFilenames) {
+			::toLowerCase(parentDir);
+		}
+		this->insertBakedEntry(entry);
+
+		if (callback) {
+			callback(parentDir, entry);
+		}
+	}
+	return true;
+}
+
+std::optional<std::span<const std::byte>> ZIP::getStoredEntryData(const Entry& entry) const {
+	if (entry.zip_compressionMethod != MZ_COMPRESS_METHOD_STORE) {
+		return std::nullopt;
+	}
+	const auto* archive = this->getMappedArchive(0);
+	if (!archive) {
+		return std::nullopt;
+	}
+
+	// The entry offset points at its local file header, the data comes after the header's variable length fields
+	constexpr std::uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+	constexpr std::uint64_t LOCAL_HEADER_LENGTH = 30;
+	auto data = archive->span();
+	std::uint64_t headerOffset = this->getZIPOffset() + entry.offset;
+	if (headerOffset + LOCAL_HEADER_LENGTH > data.size()) {
+		return std::nullopt;
+	}
+	std::uint32_t signature;
+	std::memcpy(&signature, data.data() + headerOffset, sizeof(signature));
+	if (signature != LOCAL_HEADER_SIGNATURE) {
+		return std::nullopt;
+	}
+	std::uint16_t filenameLength, extraFieldLength;
+	std::memcpy(&filenameLength, data.data() + headerOffset + 26, sizeof(filenameLength));
+	std::memcpy(&extraFieldLength, data.data() + headerOffset + 28, sizeof(extraFieldLength));
+
+	std::uint64_t dataOffset = headerOffset + LOCAL_HEADER_LENGTH + filenameLength + extraFieldLength;
+	if (dataOffset + entry.length > data.size()) {
+		return std::nullopt;
+	}
+	return data.subspan(dataOffset, entry.length);
+}
+
+std::unique_ptr<ZIPReader> ZIP::acquireZIPReader() const {
+	{
+		std::scoped_lock lock{this->zipReadersMutex};
+		if (!this->idleZIPReaders.empty()) {
+			auto reader = std::move(this->idleZIPReaders.back());
+			this->idleZIPReaders.pop_back();
+			return reader;
+		}
+	}
+	auto reader = std::make_unique<ZIPReader>();
+	if (!reader->open(this->zipPath)) {
+		return nullptr;
+	}
+	return reader;
+}
+
+void ZIP::releaseZIPReader(std::unique_ptr<ZIPReader> reader) const {
+	std::scoped_lock lock{this->zipReadersMutex};
+	this->idleZIPReaders.push_back(std::move(reader));
+}
+
+std::uint64_t ZIP::getZIPOffset() const {
+	return 0;
+}
+
 bool ZIP::openZIP(std::string_view path) {
 	this->streamHandle = mz_stream_os_create();
 	if (mz_stream_os_open(this->streamHandle, path.data(), MZ_OPEN_MODE_READ) != MZ_OK) {
@@ -240,10 +495,15 @@ bool ZIP::openZIP(std::string_view path) {
 	}
 	this->zipOpen = true;
 
+	this->zipPath = path;
 	return true;
 }
 
 void ZIP::closeZIP() {
+	{
+		std::scoped_lock lock{this->zipReadersMutex};
+		this->idleZIPReaders.clear();
+	}
 	if (this->zipOpen) {
 		mz_zip_close(this->zipHandle);
 		mz_zip_delete(&this->zipHandle);
@@ -25,8 +25,13 @@ add_library(
 
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/Adler32.h"
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/CRC32.h"
+        "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/EntryTable.h"
+        "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/FileHandlePool.h"
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/FileStream.h"
+        "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/IOQueue.h"
+        "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/MappedFile.h"
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/Misc.h"
+        "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/detail/Parallel.h"
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/BSP.h"
         "${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/Entry.h"
 		"${CMAKE_CURRENT_SOURCE_DIR}/include/vpkedit/GCF.h"
@@ -39,8 +44,13 @@ add_library(
 
         "${CMAKE_CURRENT_LIST_DIR}/detail/Adler32.cpp"
         "${CMAKE_CURRENT_LIST_DIR}/detail/CRC32.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/detail/EntryTable.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/detail/FileHandlePool.cpp"
         "${CMAKE_CURRENT_LIST_DIR}/detail/FileStream.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/detail/IOQueue.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/detail/MappedFile.cpp"
         "${CMAKE_CURRENT_LIST_DIR}/detail/Misc.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/detail/Parallel.cpp"
         "${CMAKE_CURRENT_LIST_DIR}/BSP.cpp"
         "${CMAKE_CURRENT_LIST_DIR}/Entry.cpp"
 		"${CMAKE_CURRENT_LIST_DIR}/GCF.cpp"
@@ -25,6 +25,23 @@
 
 #include <vpkedit/detail/Adler32.h>
 
+#include <algorithm>
+
+#include <vpkedit/detail/CRC32.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VPKEDIT_ADLER32_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VPKEDIT_TARGET_SSSE3
+#define VPKEDIT_TARGET_AVX2
+#else
+#define VPKEDIT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define VPKEDIT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 using namespace vpkedit;
 
 constexpr std::uint32_t BASE = 65521u;    /* largest prime smaller than 65536 */
@@ -36,11 +53,9 @@ constexpr std::size_t NMAX = 5552u;
 #define DO8(buffer,i)  DO4(buffer,i) DO4(buffer,i+4)
 #define DO16(buffer)   DO8(buffer,0) DO8(buffer,8)
 
-std::uint32_t detail::computeAdler32(const std::vector<std::byte>& buffer, std::uint32_t adler) {
-	return computeAdler32(buffer.data(), buffer.size(), adler);
-}
+namespace {
 
-std::uint32_t detail::computeAdler32(const std::byte* buffer, std::size_t len, std::uint32_t adler) {
+std::uint32_t adler32Scalar(const std::byte* buffer, std::size_t len, std::uint32_t adler) {
 	std::uint32_t sum2;
 	std::uint32_t n;
 
@@ -105,3 +120,203 @@ std::uint32_t detail::computeAdler32(const std::byte* buffer, std::size_t len, s
 	/* return recombined sums */
 	return adler | (sum2 << 16);
 }
+
+#ifdef VPKEDIT_ADLER32_SIMD
+
+/*
+	The vectorized kernels work on blocks of 32 bytes. Across a run of blocks, the first sum is the
+	sum of every byte, and the second sum grows by the first sum (as it was before the block) times 32
+	plus each byte of the block weighted by its distance from the end of the block (32, 31, ... 1).
+	Up to NMAX bytes can be summed in 32-bit lanes before either sum has to be reduced modulo BASE.
+ */
+
+/// Blocks processed by the vectorized kernels
+constexpr std::size_t SIMD_BLOCK_SIZE = 32;
+
+bool isCPUFeatureSupported(detail::Adler32Kernel kernel) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	if (kernel == detail::Adler32Kernel::SSSE3) {
+		return info[2] & (1 << 9);
+	}
+	// AVX2 needs the OS to save the upper halves of the registers too
+	const bool osSavesYMM = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesYMM && (info[1] & (1 << 5));
+#else
+	return kernel == detail::Adler32Kernel::SSSE3 ? __builtin_cpu_supports("ssse3") : __builtin_cpu_supports("avx2");
+#endif
+}
+
+/// Finish off the bytes that don't fill a block
+std::uint32_t adler32Tail(const std::byte* buffer, std::size_t len, std::uint32_t s1, std::uint32_t s2) {
+	while (len--) {
+		s1 += static_cast<unsigned char>(*buffer++);
+		s2 += s1;
+	}
+	return (s1 % BASE) | ((s2 % BASE) << 16);
+}
+
+VPKEDIT_TARGET_SSSE3 std::uint32_t adler32SSSE3(const std::byte* buffer, std::size_t len, std::uint32_t adler) {
+	std::uint32_t s1 = adler & 0xffff;
+	std::uint32_t s2 = (adler >> 16) & 0xffff;
+
+	const auto weights1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+	const auto weights2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const auto ones = _mm_set1_epi16(1);
+	const auto zero = _mm_setzero_si128();
+
+	for (auto blocks = len / SIMD_BLOCK_SIZE; blocks > 0;) {
+		auto n = std::min(blocks, NMAX / SIMD_BLOCK_SIZE);
+		blocks -= n;
+		len -= n * SIMD_BLOCK_SIZE;
+
+		// The first sum before each block, added up, gets multiplied by the block size at the end
+		auto previousS1 = _mm_set_epi32(0, 0, 0, static_cast<int>(s1 * n));
+		auto vs1 = _mm_setzero_si128();
+		auto vs2 = _mm_set_epi32(0, 0, 0, static_cast<int>(s2));
+		for (; n > 0; n--, buffer += SIMD_BLOCK_SIZE) {
+			const auto bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+			const auto bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + 16));
+			previousS1 = _mm_add_epi32(previousS1, vs1);
+			vs1 = _mm_add_epi32(vs1, _mm_add_epi32(_mm_sad_epu8(bytes1, zero), _mm_sad_epu8(bytes2, zero)));
+			vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, weights1), ones));
+			vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, weights2), ones));
+		}
+		vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(previousS1, 5));
+
+		// Add up the lanes
+		vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, _MM_SHUFFLE(2, 3, 0, 1)));
+		vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, _MM_SHUFFLE(1, 0, 3, 2)));
+		vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, _MM_SHUFFLE(2, 3, 0, 1)));
+		vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, _MM_SHUFFLE(1, 0, 3, 2)));
+		s1 = (s1 + static_cast<std::uint32_t>(_mm_cvtsi128_si32(vs1))) % BASE;
+		s2 = static_cast<std::uint32_t>(_mm_cvtsi128_si32(vs2)) % BASE;
+	}
+	return adler32Tail(buffer, len, s1, s2);
+}
+
+VPKEDIT_TARGET_AVX2 std::uint32_t adler32AVX2(const std::byte* buffer, std::size_t len, std::uint32_t adler) {
+	std::uint32_t s1 = adler & 0xffff;
+	std::uint32_t s2 = (adler >> 16) & 0xffff;
+
+	const auto weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const auto ones = _mm256_set1_epi16(1);
+	const auto zero = _mm256_setzero_si256();
+
+	for (auto blocks = len / SIMD_BLOCK_SIZE; blocks > 0;) {
+		auto n = std::min(blocks, NMAX / SIMD_BLOCK_SIZE);
+		blocks -= n;
+		len -= n * SIMD_BLOCK_SIZE;
+
+		auto previousS1 = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, static_cast<int>(s1 * n));
+		auto vs1 = _mm256_setzero_si256();
+		auto vs2 = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, static_cast<int>(s2));
+		for (; n > 0; n--, buffer += SIMD_BLOCK_SIZE) {
+			const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer));
+			previousS1 = _mm256_add_epi32(previousS1, vs1);
+			vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(bytes, zero));
+			vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+		}
+		vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(previousS1, 5));
+
+		// Add up the lanes
+		auto s1Lanes = _mm_add_epi32(_mm256_castsi256_si128(vs1), _mm256_extracti128_si256(vs1, 1));
+		auto s2Lanes = _mm_add_epi32(_mm256_castsi256_si128(vs2), _mm256_extracti128_si256(vs2, 1));
+		s1Lanes = _mm_add_epi32(s1Lanes, _mm_shuffle_epi32(s1Lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+		s1Lanes = _mm_add_epi32(s1Lanes, _mm_shuffle_epi32(s1Lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+		s2Lanes = _mm_add_epi32(s2Lanes, _mm_shuffle_epi32(s2Lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+		s2Lanes = _mm_add_epi32(s2Lanes, _mm_shuffle_epi32(s2Lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+		s1 = (s1 + static_cast<std::uint32_t>(_mm_cvtsi128_si32(s1Lanes))) % BASE;
+		s2 = static_cast<std::uint32_t>(_mm_cvtsi128_si32(s2Lanes)) % BASE;
+	}
+	return adler32Tail(buffer, len, s1, s2);
+}
+
+#endif
+
+using Adler32Function = std::uint32_t(*)(const std::byte* buffer, std::size_t len, std::uint32_t adler);
+
+Adler32Function getAdler32Function(detail::Adler32Kernel kernel) {
+	switch (kernel) {
+		case detail::Adler32Kernel::SCALAR:
+			break;
+		case detail::Adler32Kernel::SSSE3:
+#ifdef VPKEDIT_ADLER32_SIMD
+			return &adler32SSSE3;
+#else
+			break;
+#endif
+		case detail::Adler32Kernel::AVX2:
+#ifdef VPKEDIT_ADLER32_SIMD
+			return &adler32AVX2;
+#else
+			break;
+#endif
+	}
+	return &adler32Scalar;
+}
+
+/// Below this the vectorized kernels can't get going, and zlib's loop has shortcuts for tiny buffers
+constexpr std::size_t SIMD_MIN_LENGTH = 64;
+
+/// computeCRC32AndAdler32 alternates between the checksums this many bytes at a time
+constexpr std::size_t FUSED_SLICE_SIZE = 4096;
+
+} // namespace
+
+bool detail::isAdler32KernelSupported(Adler32Kernel kernel) {
+	switch (kernel) {
+		case Adler32Kernel::SCALAR:
+			return true;
+		case Adler32Kernel::SSSE3:
+		case Adler32Kernel::AVX2:
+#ifdef VPKEDIT_ADLER32_SIMD
+			return ::isCPUFeatureSupported(kernel);
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+detail::Adler32Kernel detail::getAdler32Kernel() {
+	static const auto kernel = [] {
+		for (auto candidate : {Adler32Kernel::AVX2, Adler32Kernel::SSSE3}) {
+			if (isAdler32KernelSupported(candidate)) {
+				return candidate;
+			}
+		}
+		return Adler32Kernel::SCALAR;
+	}();
+	return kernel;
+}
+
+std::uint32_t detail::computeAdler32(const std::vector<std::byte>& buffer, std::uint32_t adler) {
+	return computeAdler32(buffer.data(), buffer.size(), adler);
+}
+
+std::uint32_t detail::computeAdler32(const std::byte* buffer, std::size_t len, std::uint32_t adler) {
+	static const auto function = ::getAdler32Function(getAdler32Kernel());
+	if (len < SIMD_MIN_LENGTH) {
+		return ::adler32Scalar(buffer, len, adler);
+	}
+	return function(buffer, len, adler);
+}
+
+std::uint32_t detail::computeAdler32(Adler32Kernel kernel, const std::byte* buffer, std::size_t len, std::uint32_t adler) {
+	if (len < SIMD_MIN_LENGTH) {
+		return ::adler32Scalar(buffer, len, adler);
+	}
+	return ::getAdler32Function(kernel)(buffer, len, adler);
+}
+
+std::pair<std::uint32_t, std::uint32_t> detail::computeCRC32AndAdler32(const std::byte* buffer, std::size_t len, std::uint32_t crc32, std::uint32_t adler) {
+	for (std::size_t offset = 0; offset < len; offset += FUSED_SLICE_SIZE) {
+		const auto sliceLen = std::min(FUSED_SLICE_SIZE, len - offset);
+		crc32 = computeCRC32(buffer + offset, sliceLen, crc32);
+		adler = computeAdler32(buffer + offset, sliceLen, adler);
+	}
+	return {crc32, adler};
+}
@@ -1,15 +1,270 @@
 #include <vpkedit/detail/CRC32.h>
 
+#include <algorithm>
+
+#include <vpkedit/detail/Parallel.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VPKEDIT_CRC32_PCLMUL
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VPKEDIT_TARGET_PCLMUL
+#else
+#define VPKEDIT_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#endif
+
 using namespace vpkedit;
 
+namespace {
+
+/// CRC-32 polynomial, bit-reflected
+constexpr std::uint32_t CRC_POLY = 0xedb88320;
+
+/// Buffers are only split between threads when each one gets at least this much
+constexpr std::size_t CRC_PARALLEL_MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+/// Table k holds the CRC of a byte followed by k zero bytes, so 16 bytes can be looked up at once
+constexpr auto CRC_SLICING_TABLES = [] {
+	std::array<std::array<std::uint32_t, 256>, 16> tables{};
+	for (std::size_t i = 0; i < 256; i++) {
+		tables[0][i] = detail::CRC_TABLE[i];
+	}
+	for (std::size_t k = 1; k < tables.size(); k++) {
+		for (std::size_t i = 0; i < 256; i++) {
+			tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+		}
+	}
+	return tables;
+}();
+
+/// Multiply two polynomials modulo the CRC polynomial
+constexpr std::uint32_t multiplyModPoly(std::uint32_t a, std::uint32_t b) {
+	std::uint32_t product = 0;
+	for (std::uint32_t bit = 1u << 31; bit; bit >>= 1) {
+		if (a & bit) {
+			product ^= b;
+		}
+		b = b & 1 ? (b >> 1) ^ CRC_POLY : b >> 1;
+	}
+	return product;
+}
+
+/// Entry k is x^(2^k) modulo the CRC polynomial. Lengths are counted in bytes (x^8), so 3 + 64 are needed
+constexpr auto CRC_X2N_TABLE = [] {
+	std::array<std::uint32_t, 3 + 64> table{};
+	// x^1
+	std::uint32_t p = 1u << 30;
+	for (auto& entry : table) {
+		entry = p;
+		p = multiplyModPoly(p, p);
+	}
+	return table;
+}();
+
+/// x^(8 * n) modulo the CRC polynomial, what a CRC gets multiplied by when n zero bytes are appended
+constexpr std::uint32_t bytesShiftModPoly(std::uint64_t n) {
+	// x^0
+	std::uint32_t p = 1u << 31;
+	for (std::size_t k = 3; n; n >>= 1, k++) {
+		if (n & 1) {
+			p = multiplyModPoly(CRC_X2N_TABLE[k], p);
+		}
+	}
+	return p;
+}
+
+std::uint32_t crc32Bytewise(const std::byte* buffer, std::size_t len, std::uint32_t crc) {
+	for (std::size_t i = 0; i < len; i++) {
+		crc = (crc >> 8) ^ detail::CRC_TABLE[static_cast<unsigned int>(buffer[i]) ^ crc & 0xff];
+	}
+	return crc;
+}
+
+/// Assembled a byte at a time so it reads the same on any platform, compilers turn this into one load
+inline std::uint32_t loadLittleEndian32(const std::byte* buffer) {
+	return static_cast<std::uint32_t>(buffer[0]) | static_cast<std::uint32_t>(buffer[1]) << 8 | static_cast<std::uint32_t>(buffer[2]) << 16 | static_cast<std::uint32_t>(buffer[3]) << 24;
+}
+
+std::uint32_t crc32SlicingBy16(const std::byte* buffer, std::size_t len, std::uint32_t crc) {
+	const auto& t = CRC_SLICING_TABLES;
+	for (; len >= 16; buffer += 16, len -= 16) {
+		const auto a = loadLittleEndian32(buffer) ^ crc;
+		const auto b = loadLittleEndian32(buffer + 4);
+		const auto c = loadLittleEndian32(buffer + 8);
+		const auto d = loadLittleEndian32(buffer + 12);
+		crc = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24] ^
+		      t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff] ^ t[8][b >> 24] ^
+		      t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^ t[4][c >> 24] ^
+		      t[3][d & 0xff] ^ t[2][(d >> 8) & 0xff] ^ t[1][(d >> 16) & 0xff] ^ t[0][d >> 24];
+	}
+	return crc32Bytewise(buffer, len, crc);
+}
+
+#ifdef VPKEDIT_CRC32_PCLMUL
+
+bool isPCLMULSupported() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 1)) && (info[2] & (1 << 19));
+#else
+	return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+VPKEDIT_TARGET_PCLMUL inline __m128i load(const std::byte* data) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+/// Multiply both halves of x by the constants in k and add the next 16 bytes
+VPKEDIT_TARGET_PCLMUL inline __m128i fold(__m128i x, __m128i k, __m128i next) {
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
+}
+
+/// Folds 64 bytes at a time with carryless multiplication, then reduces to 32 bits with Barrett reduction.
+/// Constants are for the bit-reflected CRC-32 polynomial, from Intel's "Fast CRC Computation for Generic
+/// Polynomials Using PCLMULQDQ Instruction". Requires at least 64 bytes, and only handles a multiple of 16
+VPKEDIT_TARGET_PCLMUL std::uint32_t crc32PCLMULBlocks(const std::byte* buffer, std::size_t len, std::uint32_t crc) {
+	const auto k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const auto k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const auto k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+	const auto poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+
+	auto x1 = _mm_xor_si128(load(buffer), _mm_cvtsi32_si128(static_cast<int>(crc)));
+	auto x2 = load(buffer + 0x10);
+	auto x3 = load(buffer + 0x20);
+	auto x4 = load(buffer + 0x30);
+	buffer += 64;
+	len -= 64;
+
+	// Four independent folds per 64 bytes keep the multiplier busy
+	for (; len >= 64; buffer += 64, len -= 64) {
+		x1 = fold(x1, k1k2, load(buffer));
+		x2 = fold(x2, k1k2, load(buffer + 0x10));
+		x3 = fold(x3, k1k2, load(buffer + 0x20));
+		x4 = fold(x4, k1k2, load(buffer + 0x30));
+	}
+
+	// Fold down to 128 bits, then any 16 byte blocks left
+	x1 = fold(x1, k3k4, x2);
+	x1 = fold(x1, k3k4, x3);
+	x1 = fold(x1, k3k4, x4);
+	for (; len >= 16; buffer += 16, len -= 16) {
+		x1 = fold(x1, k3k4, load(buffer));
+	}
+
+	// Fold 128 bits to 64 bits
+	const auto mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduce to 32 bits
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return static_cast<std::uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+std::uint32_t crc32PCLMUL(const std::byte* buffer, std::size_t len, std::uint32_t crc) {
+	if (len >= 64) {
+		const auto blocksLen = len & ~static_cast<std::size_t>(15);
+		crc = crc32PCLMULBlocks(buffer, blocksLen, crc);
+		buffer += blocksLen;
+		len -= blocksLen;
+	}
+	return crc32SlicingBy16(buffer, len, crc);
+}
+
+#endif
+
+/// The kernels work on the CRC register, which is the CRC inverted
+using CRC32Function = std::uint32_t(*)(const std::byte* buffer, std::size_t len, std::uint32_t crc);
+
+CRC32Function getCRC32Function(detail::CRC32Kernel kernel) {
+	switch (kernel) {
+		case detail::CRC32Kernel::BYTEWISE:
+			return &crc32Bytewise;
+		case detail::CRC32Kernel::SLICING_BY_16:
+			return &crc32SlicingBy16;
+		case detail::CRC32Kernel::PCLMUL:
+#ifdef VPKEDIT_CRC32_PCLMUL
+			return &crc32PCLMUL;
+#else
+			break;
+#endif
+	}
+	return &crc32SlicingBy16;
+}
+
+} // namespace
+
+bool detail::isCRC32KernelSupported(CRC32Kernel kernel) {
+	switch (kernel) {
+		case CRC32Kernel::BYTEWISE:
+		case CRC32Kernel::SLICING_BY_16:
+			return true;
+		case CRC32Kernel::PCLMUL:
+#ifdef VPKEDIT_CRC32_PCLMUL
+			return ::isPCLMULSupported();
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+detail::CRC32Kernel detail::getCRC32Kernel() {
+	static const auto kernel = isCRC32KernelSupported(CRC32Kernel::PCLMUL) ? CRC32Kernel::PCLMUL : CRC32Kernel::SLICING_BY_16;
+	return kernel;
+}
+
 std::uint32_t detail::computeCRC32(const std::vector<std::byte>& buffer) {
     return computeCRC32(buffer.data(), buffer.size());
 }
 
-std::uint32_t detail::computeCRC32(const std::byte* buffer, std::size_t len) {
-    unsigned int crc = 0xffffffff;
-    for (std::size_t i = 0; i < len; i++) {
-        crc = (crc >> 8) ^ CRC_TABLE[static_cast<unsigned int>(buffer[i]) ^ crc & 0xff];
-    }
-    return ~crc;
+std::uint32_t detail::computeCRC32(const std::byte* buffer, std::size_t len, std::uint32_t previousCRC) {
+	static const auto function = ::getCRC32Function(getCRC32Kernel());
+	return ~function(buffer, len, ~previousCRC);
+}
+
+std::uint32_t detail::computeCRC32(CRC32Kernel kernel, const std::byte* buffer, std::size_t len, std::uint32_t previousCRC) {
+	return ~::getCRC32Function(kernel)(buffer, len, ~previousCRC);
+}
+
+std::uint32_t detail::combineCRC32(std::uint32_t firstCRC, std::uint32_t secondCRC, std::uint64_t secondLen) {
+	// Appending the second piece shifts the first CRC along by that many zero bytes, the rest is linear
+	return ::multiplyModPoly(::bytesShiftModPoly(secondLen), firstCRC) ^ secondCRC;
+}
+
+std::uint32_t detail::computeCRC32Parallel(const std::byte* buffer, std::size_t len, std::uint32_t threads) {
+	if (len < CRC_PARALLEL_MIN_CHUNK_SIZE * 2) {
+		return computeCRC32(buffer, len);
+	}
+	const auto threadCount = getThreadCount(threads, len / CRC_PARALLEL_MIN_CHUNK_SIZE);
+	if (threadCount <= 1) {
+		return computeCRC32(buffer, len);
+	}
+
+	// One piece per thread, the last piece picks up whatever doesn't divide evenly
+	const auto chunkSize = len / threadCount;
+	std::vector<std::uint32_t> crcs(threadCount);
+	runInParallel(threadCount, threadCount, [buffer, len, chunkSize, threadCount, &crcs](std::size_t i, std::vector<std::byte>&) {
+		const auto chunkLen = i == threadCount - 1 ? len - chunkSize * i : chunkSize;
+		crcs[i] = computeCRC32(buffer + chunkSize * i, chunkLen);
+		return true;
+	});
+
+	std::uint32_t crc = crcs[0];
+	for (std::size_t i = 1; i < threadCount; i++) {
+		crc = combineCRC32(crc, crcs[i], i == threadCount - 1 ? len - chunkSize * i : chunkSize);
+	}
+	return crc;
 }
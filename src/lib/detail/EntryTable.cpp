@@ -0,0 +1,284 @@
+#include <vpkedit/detail/EntryTable.h>
+
+#include <utility>
+
+#include <vpkedit/Entry.h>
+
+using namespace vpkedit;
+using namespace vpkedit::detail;
+
+namespace {
+
+// Mirrors normalizeSlashes without copying
+std::string_view trimEntryPath(std::string_view path) {
+	if (!path.empty() && (path.front() == '/' || path.front() == '\\')) {
+		path.remove_prefix(1);
+	}
+	if (!path.empty() && (path.back() == '/' || path.back() == '\\')) {
+		path.remove_suffix(1);
+	}
+	return path;
+}
+
+constexpr char foldSlash(char c) {
+	return c == '\\' ? '/' : c;
+}
+
+constexpr char foldCase(char c) {
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr std::uint32_t truncateHash(std::size_t hash) {
+	return static_cast<std::uint32_t>(static_cast<std::uint64_t>(hash) ^ (static_cast<std::uint64_t>(hash) >> 32));
+}
+
+} // namespace
+
+std::size_t detail::hashEntryPath(std::string_view path) {
+	// FNV-1a
+	std::uint64_t hash = 0xcbf29ce484222325;
+	for (char c : ::trimEntryPath(path)) {
+		hash ^= static_cast<unsigned char>(::foldCase(::foldSlash(c)));
+		hash *= 0x100000001b3;
+	}
+	return static_cast<std::size_t>(hash);
+}
+
+bool detail::compareEntryPaths(std::string_view lhs, std::string_view rhs, bool caseSensitive) {
+	lhs = ::trimEntryPath(lhs);
+	rhs = ::trimEntryPath(rhs);
+	if (lhs.length() != rhs.length()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < lhs.length(); i++) {
+		char l = ::foldSlash(lhs[i]), r = ::foldSlash(rhs[i]);
+		if (!caseSensitive) {
+			l = ::foldCase(l);
+			r = ::foldCase(r);
+		}
+		if (l != r) {
+			return false;
+		}
+	}
+	return true;
+}
+
+EntryTable::EntryTable(bool caseSensitive_)
+		: caseSensitive(caseSensitive_) {}
+
+EntryTable::Row EntryTable::add(const Entry& entry) {
+	auto row = static_cast<Row>(this->pathOffsets.size());
+
+	this->pathOffsets.push_back(static_cast<std::uint32_t>(this->pathPool.size()));
+	this->pathLengths.push_back(static_cast<std::uint32_t>(entry.path.size()));
+	this->pathPool += entry.path;
+
+	this->lengths.push_back(entry.length);
+	this->offsets.push_back(entry.offset);
+	this->crc32s.push_back(entry.crc32);
+	this->removed.push_back(false);
+
+	this->compressedLengths.push(row, entry.compressedLength);
+	this->archiveIndices.push(row, entry.vpk_archiveIndex);
+	if (!entry.vpk_preloadedData.empty()) {
+		this->preloadOffsets.push(row, static_cast<std::uint32_t>(this->preloadPool.size()));
+		this->preloadPool.insert(this->preloadPool.end(), entry.vpk_preloadedData.begin(), entry.vpk_preloadedData.end());
+	} else {
+		this->preloadOffsets.push(row, 0);
+	}
+	this->preloadLengths.push(row, static_cast<std::uint16_t>(entry.vpk_preloadedData.size()));
+	this->compressionMethods.push(row, entry.zip_compressionMethod);
+
+	this->pathHashes.push_back(::truncateHash(hashEntryPath(entry.path)));
+	if (auto indexed = this->find(entry.path)) {
+		// The first entry with a given path wins, same as a linear search would
+		this->duplicates[*indexed].push_back(row);
+	} else {
+		this->insertIntoIndex(row);
+	}
+	return row;
+}
+
+void EntryTable::remove(Row row) {
+	if (this->isRemoved(row)) {
+		return;
+	}
+	if (auto indexed = this->find(this->getPath(row)); indexed && *indexed == row) {
+		this->removeFromIndex(row);
+
+		// Promote the next duplicate if there is one, it takes over the rest of them
+		if (auto it = this->duplicates.find(row); it != this->duplicates.end()) {
+			auto rest = std::move(it->second);
+			this->duplicates.erase(it);
+			const Row promoted = rest.front();
+			rest.erase(rest.begin());
+			this->insertIntoIndex(promoted);
+			if (!rest.empty()) {
+				this->duplicates.emplace(promoted, std::move(rest));
+			}
+		}
+	} else if (indexed) {
+		// A duplicate, it's on the list of the row that's indexed
+		if (auto it = this->duplicates.find(*indexed); it != this->duplicates.end()) {
+			std::erase(it->second, row);
+			if (it->second.empty()) {
+				this->duplicates.erase(it);
+			}
+		}
+	}
+	this->removed[row] = true;
+	this->removedCount++;
+}
+
+void EntryTable::clear() {
+	*this = EntryTable{this->caseSensitive};
+}
+
+std::optional<EntryTable::Row> EntryTable::find(std::string_view path) const {
+	if (this->indexSlots.empty()) {
+		return std::nullopt;
+	}
+	const auto hash = ::truncateHash(hashEntryPath(path));
+	const auto mask = this->indexSlots.size() - 1;
+	for (auto i = hash & mask; this->indexSlots[i]; i = (i + 1) & mask) {
+		const Row row = this->indexSlots[i] - 1;
+		if (this->pathHashes[row] == hash && compareEntryPaths(this->getPath(row), path, this->caseSensitive)) {
+			return row;
+		}
+	}
+	return std::nullopt;
+}
+
+void EntryTable::get(Row row, Entry& entry) const {
+	entry.path = this->getPath(row);
+	entry.length = this->lengths[row];
+	entry.offset = this->offsets[row];
+	entry.compressedLength = this->compressedLengths[row];
+	entry.crc32 = this->crc32s[row];
+	entry.unbaked = false;
+	entry.vpk_archiveIndex = this->archiveIndices[row];
+	auto preloadedData = this->getPreloadedData(row);
+	entry.vpk_preloadedData.assign(preloadedData.begin(), preloadedData.end());
+	entry.zip_compressionMethod = this->compressionMethods[row];
+}
+
+std::size_t EntryTable::getRowCount() const {
+	return this->pathOffsets.size();
+}
+
+std::size_t EntryTable::getEntryCount() const {
+	return this->getRowCount() - this->removedCount;
+}
+
+bool EntryTable::isRemoved(Row row) const {
+	return this->removed[row];
+}
+
+std::string_view EntryTable::getPath(Row row) const {
+	return std::string_view{this->pathPool}.substr(this->pathOffsets[row], this->pathLengths[row]);
+}
+
+std::string_view EntryTable::getParentPath(Row row) const {
+	auto path = this->getPath(row);
+	auto lastSeparator = path.rfind('/');
+	return lastSeparator != std::string_view::npos ? path.substr(0, lastSeparator) : std::string_view{};
+}
+
+std::uint64_t EntryTable::getLength(Row row) const {
+	return this->lengths[row];
+}
+
+std::uint64_t EntryTable::getOffset(Row row) const {
+	return this->offsets[row];
+}
+
+std::uint64_t EntryTable::getCompressedLength(Row row) const {
+	return this->compressedLengths[row];
+}
+
+std::uint32_t EntryTable::getCRC32(Row row) const {
+	return this->crc32s[row];
+}
+
+std::uint16_t EntryTable::getArchiveIndex(Row row) const {
+	return this->archiveIndices[row];
+}
+
+std::span<const std::byte> EntryTable::getPreloadedData(Row row) const {
+	const auto length = this->preloadLengths[row];
+	if (!length) {
+		return {};
+	}
+	return {this->preloadPool.data() + this->preloadOffsets[row], length};
+}
+
+std::uint16_t EntryTable::getCompressionMethod(Row row) const {
+	return this->compressionMethods[row];
+}
+
+std::size_t EntryTable::getMemoryUsage() const {
+	return this->pathPool.capacity() +
+	       this->pathOffsets.capacity() * sizeof(std::uint32_t) +
+	       this->pathLengths.capacity() * sizeof(std::uint32_t) +
+	       this->lengths.capacity() * sizeof(std::uint64_t) +
+	       this->offsets.capacity() * sizeof(std::uint64_t) +
+	       this->crc32s.capacity() * sizeof(std::uint32_t) +
+	       this->removed.capacity() / 8 +
+	       this->compressedLengths.values.capacity() * sizeof(std::uint64_t) +
+	       this->archiveIndices.values.capacity() * sizeof(std::uint16_t) +
+	       this->preloadPool.capacity() +
+	       this->preloadOffsets.values.capacity() * sizeof(std::uint32_t) +
+	       this->preloadLengths.values.capacity() * sizeof(std::uint16_t) +
+	       this->compressionMethods.values.capacity() * sizeof(std::uint16_t) +
+	       this->indexSlots.capacity() * sizeof(Row) +
+	       this->pathHashes.capacity() * sizeof(std::uint32_t) +
+	       this->duplicates.size() * (sizeof(Row) + sizeof(std::vector<Row>));
+}
+
+void EntryTable::insertIntoIndex(Row row) {
+	// Keep the load factor at or below 50%
+	if ((this->getEntryCount() + 1) * 2 > this->indexSlots.size()) {
+		this->growIndex();
+	}
+	const auto mask = this->indexSlots.size() - 1;
+	auto i = this->pathHashes[row] & mask;
+	while (this->indexSlots[i]) {
+		i = (i + 1) & mask;
+	}
+	this->indexSlots[i] = row + 1;
+}
+
+void EntryTable::removeFromIndex(Row row) {
+	const auto mask = this->indexSlots.size() - 1;
+	auto i = this->pathHashes[row] & mask;
+	while (this->indexSlots[i] != row + 1) {
+		i = (i + 1) & mask;
+	}
+
+	// Backward shift deletion, so lookups never need tombstones
+	for (auto j = (i + 1) & mask; this->indexSlots[j]; j = (j + 1) & mask) {
+		const auto home = this->pathHashes[this->indexSlots[j] - 1] & mask;
+		// Move slot j into the hole unless its home lies cyclically within (i, j]
+		if ((i <= j) ? (home <= i || home > j) : (home <= i && home > j)) {
+			this->indexSlots[i] = this->indexSlots[j];
+			i = j;
+		}
+	}
+	this->indexSlots[i] = 0;
+}
+
+void EntryTable::growIndex() {
+	auto oldSlots = std::move(this->indexSlots);
+	this->indexSlots.assign(oldSlots.empty() ? 64 : oldSlots.size() * 2, 0);
+	const auto mask = this->indexSlots.size() - 1;
+	for (Row slot : oldSlots) {
+		if (!slot) {
+			continue;
+		}
+		auto i = this->pathHashes[slot - 1] & mask;
+		while (this->indexSlots[i]) {
+			i = (i + 1) & mask;
+		}
+		this->indexSlots[i] = slot;
+	}
+}
@@ -0,0 +1,200 @@
+#include <vpkedit/detail/FileHandlePool.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <array>
+#include <sys/sendfile.h>
+#endif
+
+using namespace vpkedit::detail;
+
+FileHandle::FileHandle(const std::string& filepath) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE) {
+		this->handle = file;
+	}
+#else
+	this->fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+FileHandle::~FileHandle() {
+#ifdef _WIN32
+	if (this->handle) {
+		CloseHandle(this->handle);
+	}
+#else
+	if (this->fd >= 0) {
+		::close(this->fd);
+	}
+#endif
+}
+
+FileHandle::operator bool() const {
+#ifdef _WIN32
+	return this->handle != nullptr;
+#else
+	return this->fd >= 0;
+#endif
+}
+
+bool FileHandle::read(std::uint64_t offset, std::span<std::byte> buffer) const {
+	while (!buffer.empty()) {
+#ifdef _WIN32
+		// Passing an offset makes ReadFile ignore the file pointer
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD bytesRead = 0;
+		auto toRead = static_cast<DWORD>(std::min<std::size_t>(buffer.size(), MAXDWORD));
+		if (!ReadFile(this->handle, buffer.data(), toRead, &bytesRead, &overlapped) || bytesRead == 0) {
+			return false;
+		}
+#else
+		auto bytesRead = ::pread(this->fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead <= 0) {
+			return false;
+		}
+#endif
+		offset += bytesRead;
+		buffer = buffer.subspan(bytesRead);
+	}
+	return true;
+}
+
+#ifndef _WIN32
+int FileHandle::getDescriptor() const {
+	return this->fd;
+}
+#endif
+
+#ifdef __linux__
+bool FileHandle::copyTo(std::uint64_t offset, std::uint64_t length, int outputDescriptor) const {
+	// Anything the kernel can't copy between these two files, it refuses before copying a single byte
+	const auto unsupported = [](int error) {
+		return error == EXDEV || error == EINVAL || error == ENOSYS || error == EOPNOTSUPP || error == EBADF;
+	};
+
+	bool tryCopyFileRange = true;
+	bool trySendfile = true;
+	while (length > 0) {
+		// Both calls are capped just under 2 GiB per call by the kernel anyway
+		const auto toCopy = static_cast<std::size_t>(std::min<std::uint64_t>(length, 0x7ffff000));
+		ssize_t bytesCopied = -1;
+		if (tryCopyFileRange) {
+			auto inputOffset = static_cast<loff_t>(offset);
+			bytesCopied = ::copy_file_range(this->fd, &inputOffset, outputDescriptor, nullptr, toCopy, 0);
+			if (bytesCopied < 0 && unsupported(errno)) {
+				tryCopyFileRange = false;
+				continue;
+			}
+		} else if (trySendfile) {
+			auto inputOffset = static_cast<off_t>(offset);
+			bytesCopied = ::sendfile(outputDescriptor, this->fd, &inputOffset, toCopy);
+			if (bytesCopied < 0 && unsupported(errno)) {
+				trySendfile = false;
+				continue;
+			}
+		} else {
+			std::array<std::byte, 64 * 1024> buffer; // NOLINT(*-pro-type-member-init)
+			auto chunk = std::span{buffer}.first(std::min(toCopy, buffer.size()));
+			if (!this->read(offset, chunk)) {
+				return false;
+			}
+			for (auto remaining = std::span<const std::byte>{chunk}; !remaining.empty();) {
+				auto bytesWritten = ::write(outputDescriptor, remaining.data(), remaining.size());
+				if (bytesWritten < 0 && errno == EINTR) {
+					continue;
+				}
+				if (bytesWritten <= 0) {
+					return false;
+				}
+				remaining = remaining.subspan(bytesWritten);
+			}
+			bytesCopied = static_cast<ssize_t>(chunk.size());
+		}
+
+		if (bytesCopied < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesCopied <= 0) {
+			// Error, or the file ended early
+			return false;
+		}
+		offset += bytesCopied;
+		length -= bytesCopied;
+	}
+	return true;
+}
+#endif
+
+FileHandlePool::FileHandlePool(std::size_t maxOpenHandles_)
+		: maxOpenHandles(std::max<std::size_t>(maxOpenHandles_, 1)) {}
+
+FileHandlePool::FileHandlePool(FileHandlePool&& other) noexcept {
+	std::scoped_lock lock{other.mutex};
+	this->maxOpenHandles = other.maxOpenHandles;
+	this->slots = std::move(other.slots);
+	this->clock = other.clock;
+}
+
+FileHandlePool& FileHandlePool::operator=(FileHandlePool&& other) noexcept {
+	if (this != &other) {
+		std::scoped_lock lock{this->mutex, other.mutex};
+		this->maxOpenHandles = other.maxOpenHandles;
+		this->slots = std::move(other.slots);
+		this->clock = other.clock;
+	}
+	return *this;
+}
+
+void FileHandlePool::clear() {
+	std::scoped_lock lock{this->mutex};
+	this->slots.clear();
+}
+
+std::shared_ptr<FileHandle> FileHandlePool::find(std::uint16_t key) {
+	std::scoped_lock lock{this->mutex};
+	// There are only ever a handful of slots, a linear search beats anything fancier
+	for (auto& slot : this->slots) {
+		if (slot.key == key) {
+			slot.lastUsed = ++this->clock;
+			return slot.handle;
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr<FileHandle> FileHandlePool::insert(std::uint16_t key, std::shared_ptr<FileHandle> handle) {
+	std::scoped_lock lock{this->mutex};
+	for (auto& slot : this->slots) {
+		if (slot.key == key) {
+			slot.lastUsed = ++this->clock;
+			return slot.handle;
+		}
+	}
+	if (this->slots.size() >= this->maxOpenHandles) {
+		auto leastRecentlyUsed = std::min_element(this->slots.begin(), this->slots.end(), [](const Slot& lhs, const Slot& rhs) {
+			return lhs.lastUsed < rhs.lastUsed;
+		});
+		this->slots.erase(leastRecentlyUsed);
+	}
+	this->slots.push_back({key, handle, ++this->clock});
+	return handle;
+}
@@ -4,7 +4,8 @@
 
 using namespace vpkedit::detail;
 
-FileStream::FileStream(const std::string& filepath, int options) {
+FileStream::FileStream(const std::string& filepath, int options)
+		: streamBuffer(std::make_unique_for_overwrite<char[]>(FILESTREAM_BUFFER_SIZE)) {
 	if ((options & FILESTREAM_OPT_CREATE_IF_NONEXISTENT) && !std::filesystem::exists(filepath)) {
 		std::ofstream create(filepath, std::ios::trunc);
 	}
@@ -23,10 +24,25 @@ FileStream::FileStream(const std::string& filepath, int options) {
 		openMode |= std::ios::out;
 		openMode |= std::ios::trunc;
 	}
+#ifdef _WIN32
+	// MSVC ignores a buffer handed over before the file is opened, it has to come before the first read or write instead
 	this->streamFile.open(filepath, openMode);
+	this->streamFile.rdbuf()->pubsetbuf(this->streamBuffer.get(), FILESTREAM_BUFFER_SIZE);
+#else
+	// libstdc++ ignores a buffer handed over after the file is opened
+	this->streamFile.rdbuf()->pubsetbuf(this->streamBuffer.get(), FILESTREAM_BUFFER_SIZE);
+	this->streamFile.open(filepath, openMode);
+#endif
 	this->streamFile.unsetf(std::ios::skipws);
 }
 
+FileStream& FileStream::operator=(FileStream&& other) noexcept {
+	// Close the file before the buffer it writes through goes away
+	this->streamFile = std::move(other.streamFile);
+	this->streamBuffer = std::move(other.streamBuffer);
+	return *this;
+}
+
 FileStream::operator bool() const {
 	return static_cast<bool>(this->streamFile);
 }
@@ -54,6 +70,11 @@ std::vector<std::byte> FileStream::readBytes(std::size_t length) {
 	return out;
 }
 
+bool FileStream::readBytes(std::span<std::byte> buffer) {
+	this->streamFile.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	return static_cast<std::size_t>(this->streamFile.gcount()) == buffer.size();
+}
+
 std::string FileStream::readString() {
 	std::string out;
 	this->read(out);
@@ -70,6 +91,10 @@ void FileStream::writeBytes(const std::vector<std::byte>& buffer) {
 	this->streamFile.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
 }
 
+void FileStream::writeBytes(std::span<const std::byte> buffer) {
+	this->streamFile.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+}
+
 void FileStream::flush() {
 	this->streamFile.flush();
 }
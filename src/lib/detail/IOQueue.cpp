@@ -0,0 +1,327 @@
+#include <vpkedit/detail/IOQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VPKEDIT_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace vpkedit::detail;
+
+#ifdef VPKEDIT_IO_URING
+
+namespace {
+
+// Talk to the kernel directly rather than depending on liburing, only a handful of calls are needed
+
+int ioUringSetup(unsigned int entries, io_uring_params* params) {
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ringFD, unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+	return static_cast<int>(::syscall(__NR_io_uring_enter, ringFD, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+// The ring indices are shared with the kernel, so they need acquire/release ordering
+
+unsigned int loadAcquire(unsigned int* value) {
+	return std::atomic_ref<unsigned int>{*value}.load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned int* value, unsigned int newValue) {
+	std::atomic_ref<unsigned int>{*value}.store(newValue, std::memory_order_release);
+}
+
+} // namespace
+
+struct IOQueue::Ring {
+	struct Slot {
+		std::optional<Read> read;
+		/// Bytes of the buffer filled so far, reads can come back short
+		std::size_t done = 0;
+	};
+
+	int fd = -1;
+
+	void* sqRing = MAP_FAILED;
+	std::size_t sqRingSize = 0;
+	void* cqRing = MAP_FAILED;
+	std::size_t cqRingSize = 0;
+	io_uring_sqe* sqes = nullptr;
+	std::size_t sqesSize = 0;
+
+	unsigned int* sqTail = nullptr;
+	unsigned int* sqMask = nullptr;
+	unsigned int* sqArray = nullptr;
+	unsigned int* cqHead = nullptr;
+	unsigned int* cqTail = nullptr;
+	unsigned int* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+
+	/// Entries written to the submission queue that the kernel hasn't been told about yet
+	unsigned int toSubmit = 0;
+
+	std::vector<Slot> slots;
+	std::vector<std::size_t> freeSlots;
+
+	explicit Ring(std::uint32_t depth) {
+		io_uring_params params{};
+		this->fd = ::ioUringSetup(depth, &params);
+		if (this->fd < 0) {
+			return;
+		}
+
+		this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+		if (singleMap) {
+			this->sqRingSize = this->cqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+		}
+
+		this->sqRing = ::mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+		if (this->sqRing == MAP_FAILED) {
+			this->close();
+			return;
+		}
+		if (singleMap) {
+			this->cqRing = this->sqRing;
+		} else {
+			this->cqRing = ::mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+			if (this->cqRing == MAP_FAILED) {
+				this->close();
+				return;
+			}
+		}
+		this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqesMapping = ::mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+		if (sqesMapping == MAP_FAILED) {
+			this->close();
+			return;
+		}
+		this->sqes = static_cast<io_uring_sqe*>(sqesMapping);
+
+		auto* sq = static_cast<std::byte*>(this->sqRing);
+		this->sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+		this->sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+		this->sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+		auto* cq = static_cast<std::byte*>(this->cqRing);
+		this->cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+		this->cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+		this->cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+		this->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+		// Never have more reads in flight than the completion queue can hold
+		auto slotCount = std::min<std::size_t>(depth, params.sq_entries);
+		this->slots.resize(slotCount);
+		this->freeSlots.reserve(slotCount);
+		for (std::size_t i = slotCount; i > 0; i--) {
+			this->freeSlots.push_back(i - 1);
+		}
+	}
+
+	Ring(const Ring& other) = delete;
+	Ring& operator=(const Ring& other) = delete;
+
+	~Ring() {
+		this->close();
+	}
+
+	explicit operator bool() const {
+		return this->fd >= 0;
+	}
+
+	void close() {
+		if (this->sqes) {
+			::munmap(this->sqes, this->sqesSize);
+			this->sqes = nullptr;
+		}
+		if (this->cqRing != MAP_FAILED && this->cqRing != this->sqRing) {
+			::munmap(this->cqRing, this->cqRingSize);
+		}
+		this->cqRing = MAP_FAILED;
+		if (this->sqRing != MAP_FAILED) {
+			::munmap(this->sqRing, this->sqRingSize);
+			this->sqRing = MAP_FAILED;
+		}
+		if (this->fd >= 0) {
+			::close(this->fd);
+			this->fd = -1;
+		}
+	}
+
+	/// Write the remaining part of a slot's read to the submission queue
+	void queue(std::size_t slotIndex) {
+		const auto& slot = this->slots[slotIndex];
+		auto remaining = slot.read->buffer.subspan(slot.done);
+
+		// Only this thread moves the tail, the kernel only moves the head
+		unsigned int tail = *this->sqTail;
+		unsigned int index = tail & *this->sqMask;
+		auto& sqe = this->sqes[index];
+		sqe = {};
+		sqe.opcode = IORING_OP_READ;
+		sqe.fd = slot.read->handle->getDescriptor();
+		sqe.off = slot.read->offset + slot.done;
+		sqe.addr = reinterpret_cast<std::uint64_t>(remaining.data());
+		// A single read is capped just under 2 GiB by the kernel anyway
+		sqe.len = static_cast<std::uint32_t>(std::min<std::size_t>(remaining.size(), 0x7ffff000));
+		sqe.user_data = slotIndex;
+		this->sqArray[index] = index;
+		::storeRelease(this->sqTail, tail + 1);
+		this->toSubmit++;
+	}
+};
+
+#else
+
+struct IOQueue::Ring {
+	explicit operator bool() const {
+		return false;
+	}
+};
+
+#endif
+
+IOQueue::IOQueue(std::uint32_t depth_, bool allowAsync)
+		: depth(std::max<std::uint32_t>(depth_, 1)) {
+#ifdef VPKEDIT_IO_URING
+	if (allowAsync) {
+		this->ring = std::make_unique<Ring>(this->depth);
+		if (!*this->ring) {
+			this->ring.reset();
+		}
+	}
+#endif
+}
+
+IOQueue::~IOQueue() {
+#ifdef VPKEDIT_IO_URING
+	// The kernel may still be writing into buffers owned by the caller, let it finish first
+	if (this->ring) {
+		while (this->getPendingCount() > 0) {
+			if (!this->wait([](std::size_t, bool) {})) {
+				break;
+			}
+		}
+	}
+#endif
+}
+
+bool IOQueue::isAsync() const {
+	return this->ring != nullptr;
+}
+
+bool IOQueue::push(Read read) {
+#ifdef VPKEDIT_IO_URING
+	if (this->ring) {
+		if (this->ring->freeSlots.empty()) {
+			return false;
+		}
+		auto slotIndex = this->ring->freeSlots.back();
+		this->ring->freeSlots.pop_back();
+		this->ring->slots[slotIndex] = {std::move(read), 0};
+		this->ring->queue(slotIndex);
+		return true;
+	}
+#endif
+	if (this->syncReads.size() >= this->depth) {
+		return false;
+	}
+	this->syncReads.push_back(std::move(read));
+	return true;
+}
+
+std::size_t IOQueue::getPendingCount() const {
+#ifdef VPKEDIT_IO_URING
+	if (this->ring) {
+		return this->ring->slots.size() - this->ring->freeSlots.size();
+	}
+#endif
+	return this->syncReads.size();
+}
+
+std::size_t IOQueue::wait(const std::function<void(std::size_t tag, bool success)>& onComplete) {
+	if (!this->getPendingCount()) {
+		return 0;
+	}
+
+#ifdef VPKEDIT_IO_URING
+	if (this->ring) {
+		auto& r = *this->ring;
+		std::size_t finished = 0;
+		while (!finished) {
+			int result = ::ioUringEnter(r.fd, r.toSubmit, 1, IORING_ENTER_GETEVENTS);
+			if (result < 0) {
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+					continue;
+				}
+				// The ring is unusable. Tear it down so nothing the kernel still has in flight can complete into a slot
+				// or buffer that gets reused, and finish the remaining reads synchronously from where they got to
+				for (auto& slot : r.slots) {
+					if (!slot.read) {
+						continue;
+					}
+					auto read = std::move(*slot.read);
+					read.offset += slot.done;
+					read.buffer = read.buffer.subspan(slot.done);
+					this->syncReads.push_back(std::move(read));
+				}
+				this->ring.reset();
+				return this->wait(onComplete);
+			}
+			r.toSubmit -= std::min<unsigned int>(r.toSubmit, result);
+
+			unsigned int head = *r.cqHead;
+			unsigned int tail = ::loadAcquire(r.cqTail);
+			for (; head != tail; head++) {
+				const auto& cqe = r.cqes[head & *r.cqMask];
+				auto slotIndex = static_cast<std::size_t>(cqe.user_data);
+				int bytesRead = cqe.res;
+				auto& slot = r.slots[slotIndex];
+
+				bool success;
+				if (bytesRead == -EINTR || bytesRead == -EAGAIN) {
+					r.queue(slotIndex);
+					continue;
+				} else if (bytesRead == -EINVAL || bytesRead == -EOPNOTSUPP) {
+					// Older kernels don't know about IORING_OP_READ, read it the slow way
+					success = slot.read->handle->read(slot.read->offset + slot.done, slot.read->buffer.subspan(slot.done));
+				} else if (bytesRead <= 0) {
+					// Error, or the file ended before the buffer was filled
+					success = false;
+				} else {
+					slot.done += bytesRead;
+					if (slot.done < slot.read->buffer.size()) {
+						r.queue(slotIndex);
+						continue;
+					}
+					success = true;
+				}
+
+				auto tag = slot.read->tag;
+				slot.read.reset();
+				r.freeSlots.push_back(slotIndex);
+				onComplete(tag, success);
+				finished++;
+			}
+			::storeRelease(r.cqHead, head);
+		}
+		return finished;
+	}
+#endif
+
+	auto read = std::move(this->syncReads.front());
+	this->syncReads.pop_front();
+	onComplete(read.tag, read.handle->read(read.offset, read.buffer));
+	return 1;
+}
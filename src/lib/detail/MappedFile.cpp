@@ -0,0 +1,115 @@
+#include <vpkedit/detail/MappedFile.h>
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace vpkedit::detail;
+
+MappedFile::MappedFile(const std::string& filepath) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return;
+	}
+	this->length = static_cast<std::size_t>(fileSize.QuadPart);
+	if (!this->length) {
+		// Empty files can't be mapped, but they're still valid
+		CloseHandle(file);
+		this->mapped = true;
+		return;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping) {
+		return;
+	}
+	this->data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	// The view keeps the mapping alive
+	CloseHandle(mapping);
+	this->mapped = this->data != nullptr;
+#else
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat fileStat{};
+	if (::fstat(fd, &fileStat) != 0) {
+		::close(fd);
+		return;
+	}
+	this->length = static_cast<std::size_t>(fileStat.st_size);
+	if (!this->length) {
+		// Empty files can't be mapped, but they're still valid
+		::close(fd);
+		this->mapped = true;
+		return;
+	}
+	void* mapping = ::mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping keeps the file alive
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		return;
+	}
+	this->data = static_cast<const std::byte*>(mapping);
+	this->mapped = true;
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+		: data(std::exchange(other.data, nullptr))
+		, length(std::exchange(other.length, 0))
+		, mapped(std::exchange(other.mapped, false)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		this->unmap();
+		this->data = std::exchange(other.data, nullptr);
+		this->length = std::exchange(other.length, 0);
+		this->mapped = std::exchange(other.mapped, false);
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	this->unmap();
+}
+
+MappedFile::operator bool() const {
+	return this->mapped;
+}
+
+std::span<const std::byte> MappedFile::span() const {
+	return {this->data, this->data ? this->length : 0};
+}
+
+std::size_t MappedFile::size() const {
+	return this->length;
+}
+
+void MappedFile::unmap() {
+	if (this->data) {
+#ifdef _WIN32
+		UnmapViewOfFile(this->data);
+#else
+		::munmap(const_cast<std::byte*>(this->data), this->length);
+#endif
+	}
+	this->data = nullptr;
+	this->length = 0;
+	this->mapped = false;
+}
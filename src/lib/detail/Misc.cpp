@@ -6,6 +6,11 @@
 
 #include <vpkedit/detail/FileStream.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace vpkedit;
 
 void detail::toLowerCase(std::string& input) {
@@ -41,3 +46,22 @@ std::vector<std::byte> detail::readFileData(const std::string& filepath, std::si
 	stream.seekInput(preloadBytesOffset);
 	return stream.readBytes(std::filesystem::file_size(filepath) - preloadBytesOffset);
 }
+
+void detail::preallocateFile(const std::string& filepath, std::uint64_t offset, std::uint64_t length) {
+#ifdef __linux__
+	if (!length) {
+		return;
+	}
+	int fd = ::open(filepath.c_str(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	// Only a hint, if the filesystem can't do it the writes will allocate as they go
+	(void) ::fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset), static_cast<off_t>(length));
+	::close(fd);
+#else
+	(void) filepath;
+	(void) offset;
+	(void) length;
+#endif
+}
@@ -0,0 +1,49 @@
+#include <vpkedit/detail/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace vpkedit;
+
+std::size_t detail::getThreadCount(std::size_t threads, std::size_t jobCount) {
+	if (!threads) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	return std::min(threads, jobCount);
+}
+
+bool detail::runInParallel(std::size_t threads, std::size_t jobCount, const ParallelJob& job, const ParallelJobCallback& callback) {
+	std::atomic<std::size_t> nextJob = 0;
+	std::atomic<bool> cancelled = false;
+	std::mutex callbackMutex;
+	std::size_t jobsDone = 0;
+	bool allSucceeded = true;
+
+	const auto work = [&] {
+		std::vector<std::byte> buffer;
+		for (std::size_t i; !cancelled && (i = nextJob++) < jobCount;) {
+			const bool success = job(i, buffer);
+
+			std::scoped_lock lock{callbackMutex};
+			jobsDone++;
+			allSucceeded &= success;
+			if (callback && !callback(i, success, jobsDone)) {
+				cancelled = true;
+			}
+		}
+	};
+
+	const auto threadCount = getThreadCount(threads, jobCount);
+	std::vector<std::thread> workers;
+	for (std::size_t i = 1; i < threadCount; i++) {
+		workers.emplace_back(work);
+	}
+	// This thread pulls its weight too
+	work();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	return allSucceeded && !cancelled;
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/detail/Adler32.h>
+#include <vpkedit/detail/CRC32.h>
+
+#include "TestHelpers.h"
+
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace vpkedit;
+
+TEST(Checksum, crc32KnownValue) {
+    constexpr std::string_view CHECK = "123456789";
+    EXPECT_EQ(detail::computeCRC32(reinterpret_cast<const std::byte*>(CHECK.data()), CHECK.size()), 0xcbf43926);
+    EXPECT_EQ(detail::computeCRC32(nullptr, 0), 0);
+}
+
+TEST(Checksum, crc32KernelsAgree) {
+    const auto data = test::randomBytes(256 * 1024, 1234);
+    std::mt19937 random{5678};
+    for (int i = 0; i < 2000; i++) {
+        // Cover short and long lengths, and every alignment
+        const std::size_t offset = random() % 64;
+        const std::size_t length = random() % (i % 2 ? 200 : data.size() - offset);
+        const auto expected = detail::computeCRC32(detail::CRC32Kernel::BYTEWISE, data.data() + offset, length);
+        for (auto kernel : {detail::CRC32Kernel::SLICING_BY_16, detail::CRC32Kernel::PCLMUL}) {
+            if (detail::isCRC32KernelSupported(kernel)) {
+                ASSERT_EQ(detail::computeCRC32(kernel, data.data() + offset, length), expected);
+            }
+        }
+        ASSERT_EQ(detail::computeCRC32(data.data() + offset, length), expected);
+    }
+}
+
+TEST(Checksum, crc32ContinueAndCombine) {
+    const auto data = test::randomBytes(64 * 1024, 4321);
+    const auto expected = detail::computeCRC32(data);
+    for (std::size_t split : {std::size_t{0}, std::size_t{1}, std::size_t{63}, std::size_t{4096}, data.size() - 17, data.size()}) {
+        const auto first = detail::computeCRC32(data.data(), split);
+        const auto second = detail::computeCRC32(data.data() + split, data.size() - split);
+        EXPECT_EQ(detail::computeCRC32(data.data() + split, data.size() - split, first), expected);
+        EXPECT_EQ(detail::combineCRC32(first, second, data.size() - split), expected);
+    }
+}
+
+TEST(Checksum, crc32Parallel) {
+    const auto data = test::randomBytes(20 * 1024 * 1024 + 13, 8765);
+    const auto expected = detail::computeCRC32(data);
+    for (std::uint32_t threads : {0u, 1u, 2u, 3u, 5u}) {
+        EXPECT_EQ(detail::computeCRC32Parallel(data.data(), data.size(), threads), expected);
+    }
+}
+
+TEST(Checksum, adler32KnownValue) {
+    constexpr std::string_view CHECK = "Wikipedia";
+    EXPECT_EQ(detail::computeAdler32(reinterpret_cast<const std::byte*>(CHECK.data()), CHECK.size(), 1), 0x11e60398);
+}
+
+TEST(Checksum, adler32KernelsAgree) {
+    // All 0xff is the worst case for the sums overflowing before they're reduced
+    auto data = test::randomBytes(256 * 1024, 2468);
+    std::vector<std::byte> saturated(data.size(), std::byte{0xff});
+    std::mt19937 random{1357};
+    for (const auto* buffer : {&data, &saturated}) {
+        for (int i = 0; i < 1000; i++) {
+            const std::size_t offset = random() % 64;
+            const std::size_t length = random() % (i % 2 ? 200 : buffer->size() - offset);
+            const std::uint32_t adler = i % 3 ? random() % 65521 | (random() % 65521) << 16 : 0;
+            const auto expected = detail::computeAdler32(detail::Adler32Kernel::SCALAR, buffer->data() + offset, length, adler);
+            for (auto kernel : {detail::Adler32Kernel::SSSE3, detail::Adler32Kernel::AVX2}) {
+                if (detail::isAdler32KernelSupported(kernel)) {
+                    ASSERT_EQ(detail::computeAdler32(kernel, buffer->data() + offset, length, adler), expected);
+                }
+            }
+            ASSERT_EQ(detail::computeAdler32(buffer->data() + offset, length, adler), expected);
+        }
+    }
+}
+
+TEST(Checksum, crc32AndAdler32) {
+    const auto data = test::randomBytes(0x8000 * 3 + 100, 9753);
+    for (std::size_t length : {std::size_t{0}, std::size_t{100}, std::size_t{0x8000}, data.size()}) {
+        const auto [crc32, adler32] = detail::computeCRC32AndAdler32(data.data(), length);
+        EXPECT_EQ(crc32, detail::computeCRC32(data.data(), length));
+        EXPECT_EQ(adler32, detail::computeAdler32(data.data(), length));
+    }
+}
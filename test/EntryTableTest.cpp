@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/detail/CRC32.h>
+#include <vpkedit/detail/EntryTable.h>
+#include <vpkedit/Entry.h>
+#include <vpkedit/VPK.h>
+
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace vpkedit;
+using namespace vpkedit::detail;
+
+namespace {
+
+/// Entries can only be made by pack files
+struct EntryFactory : public PackFile {
+    using PackFile::createNewEntry;
+};
+
+Entry makeEntry(const std::string& path, std::uint64_t length) {
+    auto entry = EntryFactory::createNewEntry();
+    entry.path = path;
+    entry.length = length;
+    return entry;
+}
+
+/// The slot a path starts probing from while the index has its first 64 slots, mirroring EntryTable
+std::size_t getHomeSlot(std::string_view path) {
+    const auto hash = static_cast<std::uint64_t>(hashEntryPath(path));
+    return static_cast<std::uint32_t>(hash ^ (hash >> 32)) & 63;
+}
+
+/// Paths that all start probing from the same slot, so they end up next to each other in one chain
+std::vector<std::string> findCollidingPaths(std::size_t count) {
+    std::vector<std::string> paths;
+    for (int i = 0; paths.size() < count; i++) {
+        auto path = "materials/collide" + std::to_string(i) + ".vmt";
+        if (getHomeSlot(path) == 0) {
+            paths.push_back(std::move(path));
+        }
+    }
+    return paths;
+}
+
+} // namespace
+
+TEST(EntryTable, removeFromMiddleOfProbeChain) {
+    const auto paths = ::findCollidingPaths(5);
+    EntryTable table;
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        table.add(::makeEntry(paths[i], i));
+    }
+
+    // Pull out the middle of the chain, everything after it has to shift back to stay reachable
+    table.remove(2);
+    EXPECT_FALSE(table.find(paths[2]));
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        if (i != 2) {
+            auto row = table.find(paths[i]);
+            ASSERT_TRUE(row);
+            EXPECT_EQ(*row, i);
+        }
+    }
+    table.remove(0);
+    table.remove(4);
+    EXPECT_FALSE(table.find(paths[0]));
+    EXPECT_FALSE(table.find(paths[4]));
+    EXPECT_TRUE(table.find(paths[1]));
+    EXPECT_TRUE(table.find(paths[3]));
+    EXPECT_EQ(table.getEntryCount(), 2);
+}
+
+TEST(EntryTable, removeInRandomOrder) {
+    // Enough entries for the index to grow a few times and for chains to wrap around the end of it
+    std::vector<std::string> paths;
+    EntryTable table;
+    for (int i = 0; i < 1000; i++) {
+        paths.push_back("dir" + std::to_string(i % 13) + "/file" + std::to_string(i) + ".txt");
+        table.add(::makeEntry(paths.back(), i));
+    }
+
+    std::vector<EntryTable::Row> order(paths.size());
+    for (EntryTable::Row i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937{42});
+    for (std::size_t removedCount = 0; removedCount < order.size(); removedCount++) {
+        table.remove(order[removedCount]);
+        // Checking everything after every removal is slow, a few spots along the way are enough
+        if (removedCount % 97 != 0 && removedCount != order.size() - 1) {
+            continue;
+        }
+        for (std::size_t i = 0; i < order.size(); i++) {
+            auto row = table.find(paths[order[i]]);
+            if (i <= removedCount) {
+                EXPECT_FALSE(row);
+            } else {
+                ASSERT_TRUE(row);
+                EXPECT_EQ(*row, order[i]);
+            }
+        }
+    }
+    EXPECT_EQ(table.getEntryCount(), 0);
+}
+
+TEST(EntryTable, removeAndAddAgain) {
+    const auto paths = ::findCollidingPaths(3);
+    EntryTable table;
+    for (const auto& path : paths) {
+        table.add(::makeEntry(path, 1));
+    }
+    table.remove(1);
+    const auto row = table.add(::makeEntry(paths[1], 2));
+    EXPECT_EQ(row, 3);
+    for (const auto& path : paths) {
+        EXPECT_TRUE(table.find(path));
+    }
+    EXPECT_EQ(*table.find(paths[1]), row);
+    EXPECT_EQ(table.getLength(*table.find(paths[1])), 2);
+    EXPECT_EQ(table.getRowCount(), 4);
+    EXPECT_EQ(table.getEntryCount(), 3);
+}
+
+TEST(EntryTable, duplicatePaths) {
+    EntryTable table;
+    table.add(::makeEntry("materials/a.vmt", 1));
+    table.add(::makeEntry("materials/b.vmt", 2));
+    table.add(::makeEntry("materials/a.vmt", 3));
+    table.add(::makeEntry("MATERIALS/A.VMT", 4));
+
+    // The first entry with a path is found, and the next one takes its place when it's removed
+    EXPECT_EQ(*table.find("materials/a.vmt"), 0);
+    table.remove(0);
+    EXPECT_EQ(*table.find("materials/a.vmt"), 2);
+    table.remove(2);
+    EXPECT_EQ(*table.find("materials/a.vmt"), 3);
+    table.remove(3);
+    EXPECT_FALSE(table.find("materials/a.vmt"));
+    EXPECT_EQ(*table.find("materials/b.vmt"), 1);
+
+    // Removing a duplicate that isn't the one being found leaves the found one alone
+    table.add(::makeEntry("materials/b.vmt", 5));
+    table.remove(4);
+    EXPECT_EQ(*table.find("materials/b.vmt"), 1);
+    EXPECT_EQ(table.getEntryCount(), 1);
+}
+
+TEST(EntryTable, findUnnormalizedPaths) {
+    EntryTable table;
+    table.add(::makeEntry("materials/models/cable.vmt", 1));
+    EXPECT_EQ(*table.find("materials/models/cable.vmt"), 0);
+    EXPECT_EQ(*table.find("Materials/Models/CABLE.vmt"), 0);
+    EXPECT_EQ(*table.find("materials\\models\\cable.vmt"), 0);
+    EXPECT_EQ(*table.find("MATERIALS\\models/Cable.VMT"), 0);
+    EXPECT_EQ(*table.find("/materials/models/cable.vmt"), 0);
+    EXPECT_FALSE(table.find("materials/models/cable.vtf"));
+    EXPECT_FALSE(table.find("materials/models"));
+
+    // Only slashes are folded when letter case matters
+    EntryTable caseSensitiveTable{true};
+    caseSensitiveTable.add(::makeEntry("materials/Models/cable.vmt", 1));
+    EXPECT_EQ(*caseSensitiveTable.find("materials\\Models\\cable.vmt"), 0);
+    EXPECT_FALSE(caseSensitiveTable.find("materials/models/cable.vmt"));
+}
+
+TEST(EntryTable, findEntryUnnormalizedPaths) {
+    const auto root = test::makeTestDirectory("vpkedit_test_find_entry");
+    const auto path = (root / "pak01_dir.vpk").string();
+    {
+        auto vpk = VPK::createEmpty(path);
+        ASSERT_TRUE(vpk);
+        vpk->addEntry("materials/models/cable.vmt", test::randomBytes(100, 1), {});
+        vpk->addEntry("sound/music.wav", test::randomBytes(200, 2), {});
+        ASSERT_TRUE(vpk->bake("", nullptr));
+    }
+
+    auto vpk = VPK::open(path);
+    ASSERT_TRUE(vpk);
+    auto entry = vpk->findEntry("Materials\\Models\\CABLE.VMT");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->path, "materials/models/cable.vmt");
+    EXPECT_EQ(entry->length, 100);
+    entry = vpk->findEntry("SOUND/music.WAV");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->length, 200);
+    EXPECT_FALSE(vpk->findEntry("sound\\music.mp3"));
+
+    // Unbaked entries are found the same way
+    vpk->addEntry("scripts/test.txt", test::randomBytes(300, 3), {});
+    entry = vpk->findEntry("SCRIPTS\\Test.TXT");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->length, 300);
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(EntryTable, materializeEntries) {
+    const auto root = test::makeTestDirectory("vpkedit_test_materialize_entries");
+    const auto path = (root / "pak01_dir.vpk").string();
+    std::map<std::string, std::vector<std::byte>> contents;
+    std::map<std::string, std::size_t> preloadLengths;
+    {
+        auto vpk = VPK::createEmpty(path);
+        ASSERT_TRUE(vpk);
+        for (int i = 0; i < 40; i++) {
+            const auto entryPath = "dir" + std::to_string(i % 4) + "/file" + std::to_string(i) + ".bin";
+            contents[entryPath] = test::randomBytes(100 + i * 50, i);
+            EntryOptions options;
+            options.vpk_saveToDirectory = i % 3 == 0;
+            options.vpk_preloadBytes = i % 2 ? 40 : 0;
+            preloadLengths[entryPath] = options.vpk_preloadBytes;
+            vpk->addEntry(entryPath, std::vector<std::byte>{contents[entryPath]}, options);
+        }
+        ASSERT_TRUE(vpk->bake("", nullptr));
+    }
+
+    auto vpk = VPK::open(path);
+    ASSERT_TRUE(vpk);
+    EXPECT_EQ(vpk->getEntryCount(), 40);
+
+    // Every way of getting an entry builds the same thing out of the table
+    std::map<std::string, std::vector<Entry>> fromCallback;
+    vpk->runForAllEntries([&fromCallback](const std::string& directory, const Entry& entry) {
+        EXPECT_EQ(directory, entry.getParentPath());
+        fromCallback[entry.path].push_back(entry);
+    });
+    ASSERT_EQ(fromCallback.size(), 40);
+    std::size_t bakedCount = 0;
+    for (const auto& [directory, entries] : vpk->getBakedEntries()) {
+        for (const auto& entry : entries) {
+            bakedCount++;
+            EXPECT_EQ(directory, entry.getParentPath());
+            const auto& other = fromCallback.at(entry.path).front();
+            EXPECT_EQ(entry.length, other.length);
+            EXPECT_EQ(entry.offset, other.offset);
+            EXPECT_EQ(entry.crc32, other.crc32);
+            EXPECT_EQ(entry.vpk_archiveIndex, other.vpk_archiveIndex);
+            EXPECT_TRUE(entry.vpk_preloadedData == other.vpk_preloadedData);
+        }
+    }
+    EXPECT_EQ(bakedCount, 40);
+    for (const auto& [entryPath, data] : contents) {
+        auto entry = vpk->findEntry(entryPath);
+        ASSERT_TRUE(entry);
+        EXPECT_FALSE(entry->unbaked);
+        EXPECT_EQ(entry->length, data.size());
+        EXPECT_EQ(entry->crc32, detail::computeCRC32(data));
+        const auto& other = fromCallback.at(entryPath).front();
+        EXPECT_EQ(entry->offset, other.offset);
+        EXPECT_EQ(entry->vpk_archiveIndex, other.vpk_archiveIndex);
+        EXPECT_EQ(entry->vpk_preloadedData.size(), preloadLengths.at(entryPath));
+        EXPECT_TRUE(std::equal(entry->vpk_preloadedData.begin(), entry->vpk_preloadedData.end(), data.begin()));
+        auto read = vpk->readEntry(*entry);
+        ASSERT_TRUE(read);
+        EXPECT_TRUE(*read == data);
+    }
+
+    // Removing an entry hides it everywhere, including the map getBakedEntries already built
+    ASSERT_TRUE(vpk->removeEntry("dir1/file5.bin"));
+    EXPECT_FALSE(vpk->findEntry("dir1/file5.bin"));
+    EXPECT_EQ(vpk->getEntryCount(), 39);
+    bakedCount = 0;
+    for (const auto& [directory, entries] : vpk->getBakedEntries()) {
+        for (const auto& entry : entries) {
+            bakedCount++;
+            EXPECT_TRUE(entry.path != "dir1/file5.bin");
+        }
+    }
+    EXPECT_EQ(bakedCount, 39);
+    bakedCount = 0;
+    vpk->runForAllEntries([&bakedCount](const std::string&, const Entry& entry) {
+        bakedCount++;
+        EXPECT_TRUE(entry.path != "dir1/file5.bin");
+    });
+    EXPECT_EQ(bakedCount, 39);
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/detail/FileStream.h>
+
+#include "TestHelpers.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace vpkedit;
+using namespace vpkedit::detail;
+
+namespace {
+
+constexpr int FILESTREAM_OPT_CREATE = FILESTREAM_OPT_WRITE | FILESTREAM_OPT_TRUNCATE | FILESTREAM_OPT_CREATE_IF_NONEXISTENT;
+
+} // namespace
+
+TEST(FileStream, nullTerminatedStrings) {
+    const auto root = test::makeTestDirectory("vpkedit_test_filestream_strings");
+    const auto path = (root / "strings.bin").string();
+
+    // The last string starts just before the end of the stream's buffer and carries on past it
+    const std::string filler(FILESTREAM_BUFFER_SIZE - 3, 'x');
+    const std::string straddling(100, 'y');
+    {
+        FileStream writer{path, FILESTREAM_OPT_CREATE};
+        writer.write(std::string{"first"});
+        writer.write(std::string{});
+        writer.write(std::string{"second"});
+        writer.write(filler, false);
+        writer.write(straddling);
+        writer.write(std::string{"unterminated"}, false);
+    }
+
+    {
+        FileStream reader{path};
+        ASSERT_TRUE(reader);
+        EXPECT_EQ(reader.readString(), "first");
+        EXPECT_EQ(reader.readString(), "");
+        EXPECT_EQ(reader.readString(), "second");
+        EXPECT_EQ(reader.tellInput(), 14);
+        reader.skipInput(filler.size());
+        EXPECT_EQ(reader.readString(), straddling);
+        // A string running into the end of the file stops there, the next one fails
+        EXPECT_EQ(reader.readString(), "unterminated");
+        EXPECT_TRUE(reader);
+        EXPECT_EQ(reader.readString(), "");
+        EXPECT_FALSE(reader);
+
+        reader = FileStream{path};
+        reader.skipInput(14 + filler.size());
+        std::string out = "leftovers";
+        reader.read(out);
+        EXPECT_EQ(out, straddling);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(FileStream, fixedLengthStrings) {
+    const auto root = test::makeTestDirectory("vpkedit_test_filestream_fixed_strings");
+    const auto path = (root / "strings.bin").string();
+    {
+        FileStream writer{path, FILESTREAM_OPT_CREATE};
+        // Padded with zeros, then cut short
+        writer.write(std::string{"abc"}, std::size_t{8});
+        writer.write(std::string{"abcdefghij"}, std::size_t{4});
+        writer.write(std::string{"tail"}, false);
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), 16);
+
+    {
+        FileStream reader{path};
+        ASSERT_TRUE(reader);
+        // Stopping at the terminator still moves past all n characters
+        EXPECT_EQ(reader.readString(8), "abc");
+        EXPECT_EQ(reader.tellInput(), 8);
+        EXPECT_EQ(reader.readString(4), "abcd");
+        EXPECT_EQ(reader.readString(0), "");
+        EXPECT_EQ(reader.tellInput(), 12);
+
+        reader.seekInput(0);
+        EXPECT_EQ(reader.readString(8, false), std::string("abc\0\0\0\0\0", 8));
+
+        // Asking for more than is left gives back what there was
+        reader.seekInput(12);
+        EXPECT_EQ(reader.readString(100), "tail");
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(FileStream, bulkReads) {
+    const auto root = test::makeTestDirectory("vpkedit_test_filestream_bulk");
+    const auto path = (root / "bulk.bin").string();
+
+    struct Pair {
+        std::uint16_t a;
+        std::uint16_t b;
+    };
+    std::vector<std::uint32_t> numbers(FILESTREAM_BUFFER_SIZE / 2);
+    for (std::uint32_t i = 0; i < numbers.size(); i++) {
+        numbers[i] = i * 2654435761u;
+    }
+    const std::array<Pair, 3> pairs{{{1, 2}, {3, 4}, {5, 6}}};
+    const std::uint16_t shorts[4]{7, 8, 9, 10};
+    const auto bytes = test::randomBytes(1000, 1);
+    {
+        FileStream writer{path, FILESTREAM_OPT_CREATE};
+        writer.write(numbers);
+        writer.write(pairs);
+        writer.write(shorts);
+        writer.writeBytes(bytes);
+    }
+
+    {
+        FileStream reader{path};
+        ASSERT_TRUE(reader);
+        std::vector<std::uint32_t> readNumbers{1, 2, 3};
+        reader.read(readNumbers, numbers.size());
+        EXPECT_TRUE(readNumbers == numbers);
+        std::array<Pair, 3> readPairs{};
+        reader.read(readPairs);
+        for (std::size_t i = 0; i < pairs.size(); i++) {
+            EXPECT_EQ(readPairs[i].a, pairs[i].a);
+            EXPECT_EQ(readPairs[i].b, pairs[i].b);
+        }
+        std::uint16_t readShorts[4]{};
+        reader.read(readShorts);
+        for (int i = 0; i < 4; i++) {
+            EXPECT_EQ(readShorts[i], shorts[i]);
+        }
+
+        // Reading nothing empties the vector
+        reader.read(readNumbers, 0);
+        EXPECT_TRUE(readNumbers.empty());
+
+        std::vector<std::byte> readBytes(bytes.size());
+        EXPECT_TRUE(reader.readBytes(std::span{readBytes}));
+        EXPECT_TRUE(readBytes == bytes);
+        // Nothing is left to fill a buffer with
+        EXPECT_FALSE(reader.readBytes(std::span{readBytes}.first(1)));
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(FileStream, moveAssignment) {
+    const auto root = test::makeTestDirectory("vpkedit_test_filestream_move");
+    const auto firstPath = (root / "first.bin").string();
+    const auto secondPath = (root / "second.bin").string();
+    {
+        FileStream first{firstPath, FILESTREAM_OPT_CREATE};
+        first.write(std::string{"first"});
+        FileStream second{secondPath, FILESTREAM_OPT_CREATE};
+        second.write(std::string{"second"});
+
+        // The second file has to be written out and closed before the buffer holding its data is replaced
+        second = std::move(first);
+        EXPECT_EQ(std::filesystem::file_size(secondPath), 7);
+        second.write(std::string{"more"});
+
+        FileStream moved{std::move(second)};
+        moved.write(std::string{"end"});
+    }
+
+    {
+        FileStream reader{firstPath};
+        EXPECT_EQ(reader.readString(), "first");
+        EXPECT_EQ(reader.readString(), "more");
+        EXPECT_EQ(reader.readString(), "end");
+        reader = FileStream{secondPath};
+        EXPECT_EQ(reader.readString(), "second");
+    }
+
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,387 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/detail/Adler32.h>
+#include <vpkedit/detail/CRC32.h>
+#include <vpkedit/GCF.h>
+
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace vpkedit;
+
+namespace {
+
+constexpr std::uint32_t GCF_BLOCK_SIZE = 0x2000;
+constexpr std::uint32_t GCF_CHECKSUM_BLOCK_SIZE = 0x8000;
+
+/// The structures making up a GCF are only visible to subclasses
+struct GCFStructs : public GCF {
+    using GCF::Header;
+    using GCF::BlockHeader;
+    using GCF::Block;
+    using GCF::DirectoryHeader;
+    using GCF::DirectoryEntry;
+    using GCF::DirectoryMapHeader;
+    using GCF::ChecksumMapHeader;
+    using GCF::ChecksumMapEntry;
+    using GCF::DataBlockHeader;
+};
+
+template<typename T>
+std::size_t append(std::vector<std::byte>& out, const T& value) {
+    const auto position = out.size();
+    out.resize(position + sizeof(T));
+    std::memcpy(out.data() + position, &value, sizeof(T));
+    return position;
+}
+
+template<typename T>
+void patch(std::vector<std::byte>& out, std::size_t position, const T& value) {
+    std::memcpy(out.data() + position, &value, sizeof(T));
+}
+
+struct GCFFile {
+    /// Path as written to the directory, with uppercase letters
+    std::string path;
+    std::vector<std::byte> data;
+    /// Where each of the file's data blocks starts in the GCF
+    std::vector<std::uint64_t> blockOffsets;
+};
+
+/// Write a GCF holding count files of random data, there's no way to create one otherwise. To give the reader a hard time:
+/// - Files are spread over a tree of directories, and every directory is listed after the files and directories inside it
+/// - Names have uppercase letters in them
+/// - Data blocks are stored in short runs in a random order, so some neighbouring blocks can be read together and some can't
+/// - Bigger files are split across two block entries, listed back to front
+std::vector<GCFFile> makeGCF(const std::filesystem::path& path, int count, std::uint32_t seed) {
+    using Structs = GCFStructs;
+    static constexpr std::uint32_t NONE = 0xffffffff;
+    std::mt19937 random{seed};
+
+    // Directory k lives in directory (k - 1) / 2, the first one in the root
+    const int directoryCount = std::max(count / 8, 4);
+    const auto getDirectoryName = [](int k) {
+        return "Dir" + std::to_string(k);
+    };
+    const auto getDirectoryPath = [&getDirectoryName](int k) {
+        std::string directoryPath;
+        for (; k > 0; k = (k - 1) / 2) {
+            directoryPath.insert(0, getDirectoryName(k) + '/');
+        }
+        return getDirectoryName(0) + '/' + directoryPath;
+    };
+    // Items are the root, then the files, then the directories deepest first
+    const auto getDirectoryItem = [count, directoryCount](int k) {
+        return static_cast<std::uint32_t>(1 + count + directoryCount - 1 - k);
+    };
+
+    std::vector<GCFFile> files(count);
+    std::vector<std::uint32_t> fileParents(count);
+    for (int i = 0; i < count; i++) {
+        // A few empty files, a few whole blocks, and some spanning several checksums
+        std::size_t size;
+        switch (i % 6) {
+            case 0: size = i % 12 ? 0 : 1; break;
+            case 1: size = GCF_BLOCK_SIZE * (1 + random() % 3); break;
+            case 2: size = random() % (GCF_BLOCK_SIZE * 20) + 1; break;
+            default: size = random() % (GCF_BLOCK_SIZE * 2) + 1; break;
+        }
+        files[i].data = test::randomBytes(size, random);
+        const auto fileName = "File" + std::to_string(i) + ".BIN";
+        if (i % 5 == 0) {
+            files[i].path = fileName;
+            fileParents[i] = 0;
+        } else {
+            const int directory = i % directoryCount;
+            files[i].path = getDirectoryPath(directory) + fileName;
+            fileParents[i] = getDirectoryItem(directory);
+        }
+    }
+
+    // Place the data blocks in runs of up to 6, then shuffle the runs
+    std::vector<std::pair<int, std::size_t>> dataBlocks;
+    for (int i = 0; i < count; i++) {
+        for (std::size_t b = 0; b * GCF_BLOCK_SIZE < files[i].data.size(); b++) {
+            dataBlocks.emplace_back(i, b);
+        }
+    }
+    std::vector<std::vector<std::pair<int, std::size_t>>> runs;
+    for (std::size_t i = 0; i < dataBlocks.size();) {
+        const auto runLength = std::min<std::size_t>(1 + random() % 6, dataBlocks.size() - i);
+        runs.emplace_back(dataBlocks.begin() + static_cast<std::ptrdiff_t>(i), dataBlocks.begin() + static_cast<std::ptrdiff_t>(i + runLength));
+        i += runLength;
+    }
+    std::shuffle(runs.begin(), runs.end(), random);
+    std::map<std::pair<int, std::size_t>, std::uint32_t> dataBlockIndices;
+    for (const auto& run : runs) {
+        for (const auto& dataBlock : run) {
+            dataBlockIndices.emplace(dataBlock, static_cast<std::uint32_t>(dataBlockIndices.size()));
+        }
+    }
+
+    // A few spare blocks that aren't used by anything
+    const auto blockCount = static_cast<std::uint32_t>(dataBlocks.size() + 8);
+    const auto itemCount = static_cast<std::uint32_t>(1 + count + directoryCount);
+    std::vector<Structs::Block> blocks(blockCount, Structs::Block{0, 0, 0, blockCount, blockCount, blockCount, NONE});
+    std::vector<std::uint32_t> fragmap(blockCount, blockCount);
+    std::vector<std::uint32_t> dirmap(itemCount, blockCount);
+    auto nextBlock = blockCount;
+    for (int i = 0; i < count; i++) {
+        const auto dataBlockCount = (files[i].data.size() + GCF_BLOCK_SIZE - 1) / GCF_BLOCK_SIZE;
+        const auto split = dataBlockCount > 3 ? dataBlockCount / 2 : dataBlockCount;
+        for (auto [begin, end] : {std::pair{std::size_t{0}, split}, std::pair{split, dataBlockCount}}) {
+            if (begin == end) {
+                continue;
+            }
+            for (auto b = begin; b + 1 < end; b++) {
+                fragmap[dataBlockIndices.at({i, b})] = dataBlockIndices.at({i, b + 1});
+            }
+            const auto length = std::min<std::uint64_t>(files[i].data.size() - begin * GCF_BLOCK_SIZE, (end - begin) * GCF_BLOCK_SIZE);
+            blocks[--nextBlock] = {1, static_cast<std::uint32_t>(begin * GCF_BLOCK_SIZE), static_cast<std::uint32_t>(length), dataBlockIndices.at({i, begin}), blockCount, blockCount, static_cast<std::uint32_t>(1 + i)};
+            dirmap[1 + i] = nextBlock;
+        }
+    }
+
+    std::vector<std::byte> out;
+    const auto headerPosition = ::append(out, Structs::Header{1, 1, 6, 440, 1, 0, 0, 0, GCF_BLOCK_SIZE, blockCount, 0});
+    ::append(out, Structs::BlockHeader{blockCount, blockCount, 0, 0, 0, 0, 0, blockCount * 2});
+    for (const auto& block : blocks) {
+        ::append(out, block);
+    }
+    for (std::uint32_t value : {blockCount, 0u, 0u, blockCount}) {
+        ::append(out, value);
+    }
+    for (auto value : fragmap) {
+        ::append(out, value);
+    }
+
+    // The directory, then the names of everything in it
+    std::string names(1, '\0');
+    const auto addName = [&names](const std::string& name) {
+        const auto offset = static_cast<std::uint32_t>(names.size());
+        names += name;
+        names += '\0';
+        return offset;
+    };
+    const auto directoryPosition = ::append(out, Structs::DirectoryHeader{0, 0, 6, itemCount, static_cast<std::uint32_t>(count), 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    ::append(out, Structs::DirectoryEntry{0, 0, 0, 0, NONE, 0, 0});
+    for (int i = 0; i < count; i++) {
+        const auto fileName = files[i].path.substr(files[i].path.rfind('/') + 1);
+        ::append(out, Structs::DirectoryEntry{addName(fileName), static_cast<std::uint32_t>(files[i].data.size()), static_cast<std::uint32_t>(i), 1, fileParents[i], 0, 0});
+    }
+    for (int k = directoryCount - 1; k >= 0; k--) {
+        ::append(out, Structs::DirectoryEntry{addName(getDirectoryName(k)), 0, 0, 0, k ? getDirectoryItem((k - 1) / 2) : 0, 0, 0});
+    }
+    for (char c : names) {
+        out.push_back(static_cast<std::byte>(c));
+    }
+    ::patch(out, directoryPosition + offsetof(Structs::DirectoryHeader, dirsize), static_cast<std::uint32_t>(out.size() - directoryPosition));
+    ::append(out, Structs::DirectoryMapHeader{1, 0});
+    for (auto value : dirmap) {
+        ::append(out, value);
+    }
+
+    // Each checksum is the CRC32 of 32KB of a file XORed with its Adler-32
+    std::vector<Structs::ChecksumMapEntry> checksumMap;
+    std::vector<std::uint32_t> checksums;
+    for (const auto& file : files) {
+        checksumMap.push_back({static_cast<std::uint32_t>((file.data.size() + GCF_CHECKSUM_BLOCK_SIZE - 1) / GCF_CHECKSUM_BLOCK_SIZE), static_cast<std::uint32_t>(checksums.size())});
+        for (std::size_t offset = 0; offset < file.data.size(); offset += GCF_CHECKSUM_BLOCK_SIZE) {
+            const auto length = std::min<std::size_t>(GCF_CHECKSUM_BLOCK_SIZE, file.data.size() - offset);
+            checksums.push_back(detail::computeCRC32(file.data.data() + offset, length) ^ detail::computeAdler32(detail::Adler32Kernel::SCALAR, file.data.data() + offset, length));
+        }
+    }
+    ::append(out, std::uint32_t{1});
+    const auto checksumSizePosition = ::append(out, std::uint32_t{0});
+    ::append(out, Structs::ChecksumMapHeader{0x14893721, 1, static_cast<std::uint32_t>(checksumMap.size()), static_cast<std::uint32_t>(checksums.size())});
+    for (const auto& entry : checksumMap) {
+        ::append(out, entry);
+    }
+    for (auto value : checksums) {
+        ::append(out, value);
+    }
+    // Stands in for the signature
+    ::append(out, std::uint32_t{0});
+    ::patch(out, checksumSizePosition, static_cast<std::uint32_t>(out.size() - checksumSizePosition - sizeof(std::uint32_t)));
+
+    const auto firstBlockOffset = static_cast<std::uint32_t>((out.size() + sizeof(Structs::DataBlockHeader) + 15) / 16 * 16);
+    ::append(out, Structs::DataBlockHeader{1, blockCount, GCF_BLOCK_SIZE, firstBlockOffset, static_cast<std::uint32_t>(dataBlocks.size()), 0});
+    out.resize(firstBlockOffset + static_cast<std::size_t>(blockCount) * GCF_BLOCK_SIZE);
+    for (const auto& [dataBlock, index] : dataBlockIndices) {
+        const auto& [i, b] = dataBlock;
+        const auto offset = firstBlockOffset + static_cast<std::uint64_t>(index) * GCF_BLOCK_SIZE;
+        const auto length = std::min<std::size_t>(GCF_BLOCK_SIZE, files[i].data.size() - b * GCF_BLOCK_SIZE);
+        std::memcpy(out.data() + offset, files[i].data.data() + b * GCF_BLOCK_SIZE, length);
+        files[i].blockOffsets.push_back(offset);
+    }
+    ::patch(out, headerPosition + offsetof(Structs::Header, filesize), static_cast<std::uint32_t>(out.size()));
+
+    std::ofstream{path, std::ios::binary}.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return files;
+}
+
+std::string toLower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return str;
+}
+
+} // namespace
+
+TEST(GCF, read) {
+    const auto root = test::makeTestDirectory("vpkedit_test_gcf_read");
+    const auto path = root / "test.gcf";
+    const auto files = ::makeGCF(path, 64, 1234);
+    auto gcf = GCF::open(path.string());
+    ASSERT_TRUE(gcf);
+    EXPECT_EQ(gcf->getEntryCount(), files.size());
+
+    for (const auto& file : files) {
+        auto entry = gcf->findEntry(file.path);
+        ASSERT_TRUE(entry);
+        ASSERT_EQ(entry->length, file.data.size());
+        auto data = gcf->readEntry(*entry);
+        ASSERT_TRUE(data);
+        EXPECT_TRUE(*data == file.data);
+        auto view = gcf->readEntryView(*entry);
+        ASSERT_TRUE(view);
+        EXPECT_TRUE(std::equal(view->begin(), view->end(), file.data.begin(), file.data.end()));
+
+        // Ranges starting and ending around the edges of data blocks, which may or may not be next to each other
+        std::vector<std::uint64_t> blockEdges;
+        for (std::uint64_t edge = GCF_BLOCK_SIZE; edge < file.data.size(); edge += GCF_BLOCK_SIZE) {
+            blockEdges.push_back(edge);
+        }
+        for (const auto& [offset, length] : test::getEdgeRanges(file.data.size(), blockEdges)) {
+            const auto range = gcf->readEntryRange(*entry, offset, length);
+            ASSERT_TRUE(range);
+            EXPECT_TRUE(std::equal(range->begin(), range->end(), file.data.begin() + static_cast<std::ptrdiff_t>(offset), file.data.begin() + static_cast<std::ptrdiff_t>(offset + length)));
+        }
+        EXPECT_FALSE(gcf->readEntryRange(*entry, file.data.size() + 1, 1));
+
+        // Streaming reads the blocks a small buffer at a time
+        auto stream = gcf->openEntryStream(*entry);
+        ASSERT_TRUE(stream);
+        data = test::readToEnd(*stream, 3000);
+        ASSERT_TRUE(data);
+        EXPECT_TRUE(*data == file.data);
+    }
+
+    gcf.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(GCF, directoryPaths) {
+    const auto root = test::makeTestDirectory("vpkedit_test_gcf_directory_paths");
+    const auto path = root / "test.gcf";
+    const auto files = ::makeGCF(path, 200, 4321);
+
+    // Directories come after everything inside them, their paths still have to be complete
+    std::set<std::string> expected;
+    for (const auto& file : files) {
+        expected.insert(::toLower(file.path));
+    }
+    std::set<std::string> opened;
+    auto gcf = GCF::open(path.string(), {}, [&opened](const std::string& directory, const Entry& entry) {
+        EXPECT_EQ(directory, entry.getParentPath());
+        opened.insert(entry.path);
+    });
+    ASSERT_TRUE(gcf);
+    EXPECT_EQ(opened, expected);
+    std::set<std::string> found;
+    gcf->runForAllEntries([&found](const std::string&, const Entry& entry) {
+        found.insert(entry.path);
+    });
+    EXPECT_EQ(found, expected);
+    EXPECT_TRUE(expected.contains("dir0/dir1/dir3/dir7/file7.bin"));
+    EXPECT_TRUE(expected.contains("file0.bin"));
+
+    // The names are left alone when uppercase letters are allowed
+    PackFileOptions options;
+    options.allowUppercaseLettersInFilenames = true;
+    gcf = GCF::open(path.string(), options);
+    ASSERT_TRUE(gcf);
+    for (const auto& file : files) {
+        auto entry = gcf->findEntry(file.path);
+        ASSERT_TRUE(entry);
+        EXPECT_EQ(entry->path, file.path);
+    }
+
+    gcf.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(GCF, verifyEntryChecksums) {
+    const auto root = test::makeTestDirectory("vpkedit_test_gcf_verify");
+    const auto path = root / "test.gcf";
+    const auto files = ::makeGCF(path, 64, 5678);
+    {
+        auto gcf = GCF::open(path.string());
+        ASSERT_TRUE(gcf);
+        EXPECT_TRUE(test::findBadEntries(*gcf, test::chunkedVerifyOptions()).empty());
+        EXPECT_TRUE(test::findBadEntries(*gcf, test::chunkedVerifyOptions(1)).empty());
+    }
+
+    // Break the first block of some files, the last of others, and both of a few, they're each reported once
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < files.size(); i += 3) {
+        const auto& blockOffsets = files[i].blockOffsets;
+        if (blockOffsets.empty()) {
+            continue;
+        }
+        // Flipping the same byte twice would put it back
+        std::set<std::uint64_t> positions;
+        if (i % 2 == 0) {
+            positions.insert(blockOffsets.front());
+        }
+        if (i % 2 == 1 || i % 4 == 0) {
+            positions.insert(blockOffsets.back() + (files[i].data.size() - 1) % GCF_BLOCK_SIZE);
+        }
+        for (auto position : positions) {
+            test::flipByte(path, position);
+        }
+        expected.push_back(::toLower(files[i].path));
+    }
+    std::sort(expected.begin(), expected.end());
+    ASSERT_TRUE(expected.size() > 10);
+
+    auto gcf = GCF::open(path.string());
+    ASSERT_TRUE(gcf);
+    EXPECT_EQ(test::findBadEntries(*gcf, test::chunkedVerifyOptions()), expected);
+    EXPECT_EQ(test::findBadEntries(*gcf, test::chunkedVerifyOptions(1)), expected);
+    VerifyOptions wholeBuffer;
+    wholeBuffer.bufferSize = 1024 * 1024;
+    EXPECT_EQ(test::findBadEntries(*gcf, wholeBuffer), expected);
+
+    // Progress is reported for every entry, and returning false stops the check
+    std::size_t calls = 0;
+    std::size_t bad = 0;
+    gcf->verifyEntryChecksums(test::chunkedVerifyOptions(), [&calls, &bad, &files](const Entry&, bool valid, std::size_t entriesDone, std::size_t entriesTotal) {
+        calls++;
+        bad += !valid;
+        EXPECT_EQ(entriesDone, calls);
+        EXPECT_EQ(entriesTotal, files.size());
+        return true;
+    });
+    EXPECT_EQ(calls, files.size());
+    EXPECT_EQ(bad, expected.size());
+    calls = 0;
+    gcf->verifyEntryChecksums(test::chunkedVerifyOptions(1), [&calls](const Entry&, bool, std::size_t, std::size_t) {
+        return ++calls < 5;
+    });
+    EXPECT_EQ(calls, 5);
+
+    gcf.reset();
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/GMA.h>
+
+#include "TestHelpers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace vpkedit;
+
+namespace {
+
+/// There's no way to create a GMA from scratch, so start from an empty one written by hand
+std::string makeEmptyGMA(const std::filesystem::path& root) {
+    const auto path = (root / "addon.gma").string();
+    std::ofstream out{path, std::ios::binary};
+    out.write("GMAD\x03", 5);
+    const std::uint64_t steamID = 0, timestamp = 0;
+    out.write(reinterpret_cast<const char*>(&steamID), sizeof(steamID));
+    out.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+    out.write("\0name\0description\0author\0", 26);
+    const std::int32_t addonVersion = 1;
+    const std::uint32_t endOfEntries = 0, fileCRC = 0;
+    out.write(reinterpret_cast<const char*>(&addonVersion), sizeof(addonVersion));
+    out.write(reinterpret_cast<const char*>(&endOfEntries), sizeof(endOfEntries));
+    out.write(reinterpret_cast<const char*>(&fileCRC), sizeof(fileCRC));
+    return path;
+}
+
+} // namespace
+
+TEST(GMA, verifyChecksums) {
+    const auto root = test::makeTestDirectory("vpkedit_test_gma");
+    const auto path = ::makeEmptyGMA(root);
+    {
+        auto gma = GMA::open(path);
+        ASSERT_TRUE(gma);
+        std::mt19937 random{1234};
+        for (int i = 0; i < 64; i++) {
+            gma->addEntry("materials/file" + std::to_string(i) + ".vtf", test::randomBytes(random() % 20000 + 1, random), {});
+        }
+        ASSERT_TRUE(gma->bake("", nullptr));
+    }
+
+    std::vector<Entry> corrupted;
+    {
+        auto gma = GMA::open(path);
+        ASSERT_TRUE(gma);
+        EXPECT_TRUE(gma->verifyFileChecksum());
+        EXPECT_TRUE(test::findBadEntries(*gma, test::chunkedVerifyOptions()).empty());
+
+        gma->runForAllEntries([&corrupted](const std::string&, const Entry& entry) {
+            if (entry.length > 8000 && corrupted.size() < 3) {
+                corrupted.push_back(entry);
+            }
+        });
+        ASSERT_EQ(corrupted.size(), 3);
+    }
+
+    // Flip a byte in the middle of a few entries
+    const auto expected = test::corruptEntries(corrupted, [&path](const Entry& entry) {
+        return std::pair{std::filesystem::path{path}, entry.offset + entry.length / 2};
+    });
+
+    auto gma = GMA::open(path);
+    ASSERT_TRUE(gma);
+    EXPECT_FALSE(gma->verifyFileChecksum());
+    EXPECT_EQ(test::findBadEntries(*gma, test::chunkedVerifyOptions()), expected);
+
+    gma.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(GMA, failedBakeKeepsEntries) {
+    const auto root = test::makeTestDirectory("vpkedit_test_gma_failed_bake");
+    const auto path = ::makeEmptyGMA(root);
+    test::writeRandomFiles(root / "content", 2, 4321, 1000, 1000, [](int i) {
+        return "file" + std::to_string(i) + ".vtf";
+    });
+
+    auto gma = GMA::open(path);
+    ASSERT_TRUE(gma);
+    gma->addEntry("materials/file0.vtf", (root / "content" / "file0.vtf").string(), {});
+    gma->addEntry("materials/file1.vtf", (root / "content" / "file1.vtf").string(), {});
+
+    // The file an entry came from shrinking makes it unreadable, and a directory in the way of the temporary file fails the bake
+    std::filesystem::resize_file(root / "content" / "file1.vtf", 10);
+    std::filesystem::create_directories(root / "addon.gma.tmp" / "in_the_way");
+    ASSERT_FALSE(gma->bake("", nullptr));
+
+    auto entry = gma->findEntry("materials/file1.vtf");
+    ASSERT_TRUE(entry);
+    EXPECT_TRUE(entry->unbaked);
+    EXPECT_EQ(entry->length, 1000);
+    entry = gma->findEntry("materials/file0.vtf");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->length, 1000);
+    auto data = gma->readEntry(*entry);
+    ASSERT_TRUE(data);
+    EXPECT_EQ(data->size(), 1000);
+
+    // With the way clear it bakes, leaving the unreadable entry empty
+    std::filesystem::remove_all(root / "addon.gma.tmp");
+    ASSERT_TRUE(gma->bake("", nullptr));
+    gma = GMA::open(path);
+    ASSERT_TRUE(gma);
+    entry = gma->findEntry("materials/file0.vtf");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->length, 1000);
+    entry = gma->findEntry("materials/file1.vtf");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->length, 0);
+
+    gma.reset();
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <vpkedit/PackFile.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Helpers for tests that generate the pack files they read, so they don't need any games installed
+namespace vpkedit::test {
+
+/// An empty directory in the temp folder for a test to work in
+inline std::filesystem::path makeTestDirectory(std::string_view name) {
+    auto root = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    return root;
+}
+
+inline std::vector<std::byte> randomBytes(std::size_t size, std::mt19937& random) {
+    std::vector<std::byte> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<std::byte>(random());
+    }
+    return data;
+}
+
+inline std::vector<std::byte> randomBytes(std::size_t size, std::uint32_t seed) {
+    std::mt19937 random{seed};
+    return randomBytes(size, random);
+}
+
+/// Write count files of random data between minSize and maxSize bytes long, getPath names the file with the given index
+inline void writeRandomFiles(const std::filesystem::path& directory, int count, std::uint32_t seed, std::size_t minSize, std::size_t maxSize, const std::function<std::string(int)>& getPath) {
+    std::mt19937 random{seed};
+    for (int i = 0; i < count; i++) {
+        const auto data = randomBytes(minSize + random() % (maxSize - minSize + 1), random);
+        const auto path = directory / getPath(i);
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream{path, std::ios::binary}.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+}
+
+/// XOR the byte at the given position in a file, doing it twice puts it back
+inline void flipByte(const std::filesystem::path& path, std::uint64_t position) {
+    std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+    file.seekg(static_cast<std::streamoff>(position));
+    const auto c = static_cast<char>(file.get() ^ 0x5a);
+    file.seekp(static_cast<std::streamoff>(position));
+    file.put(c);
+}
+
+/// Flip a byte in each entry's data, locate gives the file the entry's data is in and the position of a byte in it.
+/// Returns the sorted paths of the entries, which is what verifyEntryChecksums should report afterward
+inline std::vector<std::string> corruptEntries(const std::vector<Entry>& entries, const std::function<std::pair<std::filesystem::path, std::uint64_t>(const Entry&)>& locate) {
+    std::vector<std::string> paths;
+    for (const auto& entry : entries) {
+        const auto [file, position] = locate(entry);
+        flipByte(file, position);
+        paths.push_back(entry.path);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+/// Every entry in the pack file, unbaked ones included
+inline std::vector<Entry> collectEntries(const PackFile& packFile) {
+    std::vector<Entry> entries;
+    packFile.runForAllEntries([&entries](const std::string&, const Entry& entry) {
+        entries.push_back(entry);
+    });
+    return entries;
+}
+
+/// Offsets and lengths worth reading out of an entry: nothing, everything, the first and last bytes, and a few
+/// bytes either side of each split point (e.g. where a VPK entry's preloaded bytes end). Every range lies inside the entry
+inline std::vector<std::pair<std::uint64_t, std::uint64_t>> getEdgeRanges(std::uint64_t length, const std::vector<std::uint64_t>& splits = {}) {
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges{{0, 0}, {0, length}, {length, 0}, {length / 2, length - length / 2}};
+    if (length) {
+        ranges.emplace_back(0, 1);
+        ranges.emplace_back(length - 1, 1);
+    }
+    for (auto split : splits) {
+        for (std::uint64_t before : {1, 3}) {
+            for (std::uint64_t after : {1, 5}) {
+                if (split >= before && split + after <= length) {
+                    ranges.emplace_back(split - before, before + after);
+                }
+            }
+        }
+        if (split <= length) {
+            ranges.emplace_back(0, split);
+            ranges.emplace_back(split, length - split);
+        }
+    }
+    return ranges;
+}
+
+/// Read the rest of a stream chunkSize bytes at a time, std::nullopt if a read fails
+inline std::optional<std::vector<std::byte>> readToEnd(EntryReader& reader, std::size_t chunkSize) {
+    std::vector<std::byte> out;
+    std::vector<std::byte> chunk(chunkSize);
+    while (true) {
+        const auto read = reader.read(chunk);
+        if (!read) {
+            return std::nullopt;
+        }
+        if (!*read) {
+            return out;
+        }
+        out.insert(out.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(*read));
+    }
+}
+
+/// The whole contents of a file on disk
+inline std::vector<std::byte> readFile(const std::filesystem::path& path) {
+    std::vector<std::byte> data(std::filesystem::file_size(path));
+    std::ifstream{path, std::ios::binary}.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return data;
+}
+
+/// Extract every entry, once with a buffer big enough for all of them and once with a small one that makes bigger
+/// entries get copied a chunk at a time, and compare each extracted file with what readEntry gives back
+inline void checkExtractAll(const PackFile& packFile, const std::filesystem::path& outputDir) {
+    for (std::uint32_t bufferSize : {ExtractOptions{}.bufferSize, std::uint32_t{4096}}) {
+        std::filesystem::remove_all(outputDir);
+        ExtractOptions options;
+        options.bufferSize = bufferSize;
+        ASSERT_TRUE(packFile.extractAll(outputDir.string(), options));
+        for (const auto& entry : collectEntries(packFile)) {
+            const auto expected = packFile.readEntry(entry);
+            ASSERT_TRUE(expected);
+            EXPECT_TRUE(readFile(outputDir / entry.path) == *expected);
+        }
+    }
+}
+
+/// A small buffer makes bigger entries get checked a chunk at a time
+inline VerifyOptions chunkedVerifyOptions(std::uint32_t threads = 0) {
+    VerifyOptions options;
+    options.threads = threads;
+    options.bufferSize = 4096;
+    return options;
+}
+
+/// The entries whose checksums don't match, sorted so they can be compared with corruptEntries
+inline std::vector<std::string> findBadEntries(const PackFile& packFile, VerifyOptions options) {
+    auto bad = packFile.verifyEntryChecksums(options);
+    std::sort(bad.begin(), bad.end());
+    return bad;
+}
+
+} // namespace vpkedit::test
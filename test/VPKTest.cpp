@@ -1,9 +1,22 @@
 #include <gtest/gtest.h>
 
+#include <vpkedit/detail/CRC32.h>
 #include <vpkedit/VPK.h>
 
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <span>
 #include <string_view>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 // These tests will need Portal 2 installed on your main drive
@@ -19,6 +32,46 @@ constexpr auto PORTAL2_PAK_PATH =
 
 using namespace vpkedit;
 
+namespace {
+
+/// Entries in dir0 go in the directory VPK, .vmt files get preloaded bytes, and the rest go in numbered archives
+std::tuple<bool, std::uint32_t> mixedEntryPlacement(const std::string& path) {
+    return {path.starts_with("dir0"), path.ends_with(".vmt") ? VPK_MAX_PRELOAD_BYTES : 0};
+}
+
+/// A VPK holding entries of every shape: in the directory VPK and in archives, with and without preloaded bytes,
+/// entirely preloaded, empty, and unbaked ones added after opening it
+std::unique_ptr<PackFile> openMixedVPK(const std::filesystem::path& root) {
+    test::writeRandomFiles(root / "content", 64, 2222, 0, 20000, [](int i) {
+        return "dir" + std::to_string(i % 4) + "/file" + std::to_string(i) + (i % 2 ? ".vmt" : ".bin");
+    });
+    for (std::size_t size : {std::size_t{0}, std::size_t{10}, std::size_t{VPK_MAX_PRELOAD_BYTES}, std::size_t{VPK_MAX_PRELOAD_BYTES + 1}}) {
+        for (const auto* directory : {"dir0", "dir1"}) {
+            const auto data = test::randomBytes(size, static_cast<std::uint32_t>(size));
+            std::ofstream{root / "content" / directory / ("sized" + std::to_string(size) + ".vmt"), std::ios::binary}.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+    }
+
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 256 * 1024;
+    const auto path = (root / "pak01_dir.vpk").string();
+    if (!VPK::createFromDirectoryProcedural(path, (root / "content").string(), ::mixedEntryPlacement, options)) {
+        return nullptr;
+    }
+    auto vpk = VPK::open(path, options);
+    if (!vpk) {
+        return nullptr;
+    }
+    EntryOptions preload;
+    preload.vpk_preloadBytes = 100;
+    vpk->addEntry("unbaked/buffer.bin", test::randomBytes(5000, 1), preload);
+    vpk->addEntry("unbaked/file.bin", (root / "content" / "dir1" / "file1.vmt").string(), preload);
+    vpk->addEntry("unbaked/tiny.bin", test::randomBytes(50, 2), preload);
+    return vpk;
+}
+
+} // namespace
+
 TEST(VPK, read) {
     auto vpk = VPK::open(PORTAL2_PAK_PATH);
     ASSERT_TRUE(vpk);
@@ -26,7 +79,7 @@ TEST(VPK, read) {
     for (const auto& [directory, files] : vpk->getBakedEntries()) {
         for (const auto& file : files) {
             // Terminal explosion
-            std::cout << directory << '/' << file.filename << '\n';
+            std::cout << file.path << '\n';
         }
     }
 }
@@ -42,7 +95,540 @@ TEST(VPK, readContents) {
     ASSERT_EQ(cableVMT->length, 46);
 
     std::string_view expectedContents = "SplineRope\r\n{\r\n$basetexture \"cable\\black\"\r\n}\r\n";
-    auto actualContents = vpk->readTextEntry(*cableVMT);
+    auto actualContents = vpk->readEntryText(*cableVMT);
     ASSERT_TRUE(actualContents);
     ASSERT_STREQ(actualContents->c_str(), expectedContents.data());
 }
+
+TEST(VPK, concurrentReads) {
+    const auto root = test::makeTestDirectory("vpkedit_test_concurrent_reads");
+    test::writeRandomFiles(root / "content", 512, 1234, 0, 20000, [](int i) {
+        return "dir" + std::to_string(i % 16) + "/file" + std::to_string(i) + ".bin";
+    });
+
+    // Small chunks spread the data across plenty of archives, more than can be kept open at once
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 256 * 1024;
+    options.maxOpenArchives = 4;
+    ASSERT_TRUE(VPK::createFromDirectory((root / "pak01_dir.vpk").string(), (root / "content").string(), false, options));
+    auto vpk = VPK::open((root / "pak01_dir.vpk").string(), options);
+    ASSERT_TRUE(vpk);
+
+    std::vector<Entry> entries;
+    vpk->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+        entries.push_back(entry);
+    });
+    ASSERT_EQ(entries.size(), 512);
+
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&vpk, &entries, &failures, t] {
+            std::vector<std::byte> buffer;
+            for (int pass = 0; pass < 4; pass++) {
+                // Every thread walks the entries in a different order so reads collide all over the place
+                for (std::size_t i = 0; i < entries.size(); i++) {
+                    const auto& entry = entries[(i * (t * 2 + 1) + pass * 97) % entries.size()];
+                    bool ok;
+                    switch ((i + t) % 3) {
+                        case 0: {
+                            auto data = vpk->readEntry(entry);
+                            ok = data && detail::computeCRC32(*data) == entry.crc32;
+                            break;
+                        }
+                        case 1:
+                            ok = vpk->readEntryInto(entry, buffer) && detail::computeCRC32(buffer) == entry.crc32;
+                            break;
+                        default: {
+                            auto view = vpk->readEntryView(entry);
+                            ok = view && detail::computeCRC32(view->data(), view->size()) == entry.crc32 && vpk->findEntry(entry.path);
+                            break;
+                        }
+                    }
+                    if (!ok) {
+                        failures++;
+                    }
+                }
+            }
+            if (vpk->getBakedEntries().empty()) {
+                failures++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, createFromDirectoryDeterministic) {
+    const auto root = test::makeTestDirectory("vpkedit_test_deterministic");
+    test::writeRandomFiles(root / "content", 256, 5678, 0, 20000, [](int i) {
+        return "dir" + std::to_string(i % 7) + "/sub" + std::to_string(i % 3) + "/file" + std::to_string(i) + (i % 2 ? ".vmt" : ".bin");
+    });
+
+    const auto readFile = [](const std::filesystem::path& path) {
+        std::ifstream file{path, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    };
+
+    // The same content should make the same bytes however many threads pack it
+    std::map<std::string, std::string> firstFiles;
+    for (std::uint32_t threads : {1u, 2u, 8u}) {
+        const auto output = root / ("out" + std::to_string(threads));
+        std::filesystem::create_directories(output);
+
+        PackFileOptions options;
+        options.vpk_preferredChunkSize = 256 * 1024;
+        options.vpk_generateMD5Entries = true;
+        options.vpk_createFromDirectoryThreads = threads;
+        auto vpk = VPK::createFromDirectoryProcedural((output / "pak01_dir.vpk").string(), (root / "content").string(), ::mixedEntryPlacement, options);
+        ASSERT_TRUE(vpk);
+        EXPECT_EQ(vpk->getEntryCount(), 256);
+        EXPECT_TRUE(vpk->verifyFileChecksum());
+        vpk.reset();
+
+        std::map<std::string, std::string> files;
+        for (const auto& file : std::filesystem::directory_iterator{output}) {
+            files[file.path().filename().string()] = readFile(file.path());
+        }
+        if (firstFiles.empty()) {
+            firstFiles = std::move(files);
+        } else {
+            EXPECT_EQ(files, firstFiles);
+        }
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, verifyEntryChecksums) {
+    const auto root = test::makeTestDirectory("vpkedit_test_verify");
+    test::writeRandomFiles(root / "content", 256, 4321, 1, 20000, [](int i) {
+        return "dir" + std::to_string(i % 5) + "/file" + std::to_string(i) + (i % 2 ? ".vmt" : ".bin");
+    });
+
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 256 * 1024;
+    ASSERT_TRUE(VPK::createFromDirectoryProcedural((root / "pak01_dir.vpk").string(), (root / "content").string(), ::mixedEntryPlacement, options));
+    {
+        auto vpk = VPK::open((root / "pak01_dir.vpk").string(), options);
+        ASSERT_TRUE(vpk);
+        std::size_t callbacks = 0;
+        EXPECT_TRUE(vpk->verifyEntryChecksums(test::chunkedVerifyOptions(), [&callbacks](const Entry&, bool valid, std::size_t entriesDone, std::size_t entriesTotal) {
+            callbacks++;
+            EXPECT_TRUE(valid);
+            EXPECT_EQ(entriesTotal, 256);
+            EXPECT_EQ(entriesDone, callbacks);
+            return true;
+        }).empty());
+        EXPECT_EQ(callbacks, 256);
+    }
+
+    // Corrupt a few entries stored in the numbered archives
+    std::vector<std::string> expected;
+    {
+        auto vpk = VPK::open((root / "pak01_dir.vpk").string(), options);
+        ASSERT_TRUE(vpk);
+        std::vector<Entry> corrupted;
+        vpk->runForAllEntries([&corrupted](const std::string&, const Entry& entry) {
+            if (entry.vpk_archiveIndex != VPK_DIR_INDEX && entry.length > entry.vpk_preloadedData.size() + 8000 && corrupted.size() < 5) {
+                corrupted.push_back(entry);
+            }
+        });
+        ASSERT_EQ(corrupted.size(), 5);
+        vpk.reset();
+
+        expected = test::corruptEntries(corrupted, [&root](const Entry& entry) {
+            char archiveName[32];
+            std::snprintf(archiveName, sizeof(archiveName), "pak01_%03d.vpk", entry.vpk_archiveIndex);
+            return std::make_pair(root / archiveName, entry.offset + (entry.length - entry.vpk_preloadedData.size()) / 2);
+        });
+    }
+    for (std::uint32_t threads : {1u, 4u}) {
+        auto vpk = VPK::open((root / "pak01_dir.vpk").string(), options);
+        ASSERT_TRUE(vpk);
+        EXPECT_EQ(test::findBadEntries(*vpk, test::chunkedVerifyOptions(threads)), expected);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, verifyFileChecksum) {
+    const auto root = test::makeTestDirectory("vpkedit_test_verify_file");
+    test::writeRandomFiles(root / "content", 64, 8765, 1, 20000, [](int i) {
+        return "file" + std::to_string(i) + (i % 2 ? ".vmt" : ".bin");
+    });
+
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 256 * 1024;
+    options.vpk_generateMD5Entries = true;
+    const auto dirPath = (root / "pak01_dir.vpk").string();
+    ASSERT_TRUE(VPK::createFromDirectoryProcedural(dirPath, (root / "content").string(), [](const std::string& path) {
+        return std::make_tuple(false, path.ends_with(".vmt") ? VPK_MAX_PRELOAD_BYTES : 0);
+    }, options));
+
+    const auto verify = [&dirPath](bool verifyMD5Entries) {
+        PackFileOptions verifyOptions;
+        verifyOptions.vpk_verifyMD5Entries = verifyMD5Entries;
+        auto vpk = VPK::open(dirPath, verifyOptions);
+        return vpk && vpk->verifyFileChecksum();
+    };
+    EXPECT_TRUE(verify(false));
+    EXPECT_TRUE(verify(true));
+
+    // Archive data is only covered by the MD5 entries
+    test::flipByte(root / "pak01_000.vpk", 100);
+    EXPECT_TRUE(verify(false));
+    EXPECT_FALSE(verify(true));
+    test::flipByte(root / "pak01_000.vpk", 100);
+
+    // The tree is covered by its own checksum
+    test::flipByte(dirPath, 40);
+    EXPECT_FALSE(verify(false));
+    test::flipByte(dirPath, 40);
+    EXPECT_TRUE(verify(true));
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, rebakeDuplicatePathMD5Entries) {
+    const auto root = test::makeTestDirectory("vpkedit_test_rebake_duplicate");
+    test::writeRandomFiles(root / "content", 32, 2468, 1, 20000, [](int i) {
+        return "file" + std::to_string(i) + ".bin";
+    });
+
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 256 * 1024;
+    options.vpk_generateMD5Entries = true;
+    const auto dirPath = (root / "pak01_dir.vpk").string();
+    ASSERT_TRUE(VPK::createFromDirectory(dirPath, (root / "content").string(), false, options));
+
+    // Adding an entry doesn't replace a baked one with the same path, each keeps its own data and checksum
+    {
+        auto vpk = VPK::open(dirPath, options);
+        ASSERT_TRUE(vpk);
+        vpk->addEntry("file0.bin", test::randomBytes(5000, 1), {});
+        EntryOptions saveToDirectory;
+        saveToDirectory.vpk_saveToDirectory = true;
+        vpk->addEntry("file1.bin", test::randomBytes(6000, 2), saveToDirectory);
+        ASSERT_TRUE(vpk->bake("", nullptr));
+    }
+
+    PackFileOptions verifyOptions;
+    verifyOptions.vpk_verifyMD5Entries = true;
+    auto vpk = VPK::open(dirPath, verifyOptions);
+    ASSERT_TRUE(vpk);
+    EXPECT_EQ(vpk->getEntryCount(), 34);
+    EXPECT_TRUE(vpk->verifyFileChecksum());
+    EXPECT_TRUE(vpk->verifyEntryChecksums().empty());
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, extractStaysInOutputDirectory) {
+    const auto root = test::makeTestDirectory("vpkedit_test_extract_traversal");
+    auto vpk = VPK::createEmpty((root / "pak01_dir.vpk").string());
+    ASSERT_TRUE(vpk);
+    vpk->addEntry("materials/safe.vmt", test::randomBytes(100, 1), {});
+    vpk->addEntry("materials/../also_safe.vmt", test::randomBytes(100, 2), {});
+    vpk->addEntry("../escaped.vmt", test::randomBytes(100, 3), {});
+    vpk->addEntry("materials/../../../escaped_further.vmt", test::randomBytes(100, 4), {});
+
+    // Entries pointing outside the output directory fail, the others are still written
+    std::vector<std::string> failed;
+    EXPECT_FALSE(vpk->extractAll((root / "out").string(), {}, [&failed](const Entry& entry, bool success, std::size_t, std::size_t) {
+        if (!success) {
+            failed.push_back(entry.path);
+        }
+        return true;
+    }));
+    std::sort(failed.begin(), failed.end());
+    EXPECT_EQ(failed, (std::vector<std::string>{"../escaped.vmt", "materials/../../../escaped_further.vmt"}));
+    EXPECT_TRUE(std::filesystem::exists(root / "out" / "materials" / "safe.vmt"));
+    EXPECT_TRUE(std::filesystem::exists(root / "out" / "also_safe.vmt"));
+    EXPECT_FALSE(std::filesystem::exists(root / "escaped.vmt"));
+    EXPECT_FALSE(std::filesystem::exists(root.parent_path() / "escaped_further.vmt"));
+    EXPECT_FALSE(std::filesystem::exists(root.parent_path().parent_path() / "escaped_further.vmt"));
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, readEntryView) {
+    const auto root = test::makeTestDirectory("vpkedit_test_read_entry_view");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+    const auto entries = test::collectEntries(*vpk);
+    ASSERT_EQ(entries.size(), 75);
+
+    for (const auto& entry : entries) {
+        const auto expected = vpk->readEntry(entry);
+        ASSERT_TRUE(expected);
+        ASSERT_EQ(expected->size(), entry.length);
+        auto view = vpk->readEntryView(entry);
+        ASSERT_TRUE(view);
+        EXPECT_TRUE(std::equal(view->begin(), view->end(), expected->begin(), expected->end()));
+        // Only baked data stored in one piece can be handed out without a copy
+        EXPECT_EQ(view->isMapped(), !entry.unbaked && entry.vpk_preloadedData.empty());
+    }
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, readEntryInto) {
+    const auto root = test::makeTestDirectory("vpkedit_test_read_entry_into");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+
+    // One buffer is reused for every entry, so leftovers from a bigger entry would show up in a smaller one
+    std::vector<std::byte> reused;
+    for (const auto& entry : test::collectEntries(*vpk)) {
+        const auto expected = vpk->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        std::vector<std::byte> exact(entry.length);
+        EXPECT_TRUE(vpk->readEntryInto(entry, std::span{exact}));
+        EXPECT_TRUE(exact == *expected);
+
+        // Only the start of a bigger buffer is written
+        std::vector<std::byte> bigger(entry.length + 16, std::byte{0x7f});
+        EXPECT_TRUE(vpk->readEntryInto(entry, std::span{bigger}));
+        EXPECT_TRUE(std::equal(expected->begin(), expected->end(), bigger.begin()));
+        EXPECT_TRUE(std::all_of(bigger.begin() + static_cast<std::ptrdiff_t>(entry.length), bigger.end(), [](std::byte b) { return b == std::byte{0x7f}; }));
+
+        if (entry.length) {
+            std::vector<std::byte> smaller(entry.length - 1);
+            EXPECT_FALSE(vpk->readEntryInto(entry, std::span{smaller}));
+        }
+
+        EXPECT_TRUE(vpk->readEntryInto(entry, reused));
+        EXPECT_TRUE(reused == *expected);
+    }
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, readEntryRange) {
+    const auto root = test::makeTestDirectory("vpkedit_test_read_entry_range");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+
+    for (const auto& entry : test::collectEntries(*vpk)) {
+        const auto expected = vpk->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        // Preloaded bytes come out of the directory VPK and the rest out of an archive, ranges crossing
+        // between the two have to stitch them together
+        for (const auto& [offset, length] : test::getEdgeRanges(entry.length, {entry.vpk_preloadedData.size(), 100, VPK_MAX_PRELOAD_BYTES})) {
+            const auto begin = expected->begin() + static_cast<std::ptrdiff_t>(offset);
+            const auto range = vpk->readEntryRange(entry, offset, length);
+            ASSERT_TRUE(range);
+            EXPECT_TRUE(std::equal(range->begin(), range->end(), begin, begin + static_cast<std::ptrdiff_t>(length)));
+
+            std::vector<std::byte> buffer(length);
+            EXPECT_TRUE(vpk->readEntryRangeInto(entry, offset, buffer));
+            EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), begin, begin + static_cast<std::ptrdiff_t>(length)));
+        }
+
+        // Ranges running off the end are cut short by readEntryRange and refused by readEntryRangeInto
+        const auto tail = vpk->readEntryRange(entry, entry.length / 2, entry.length);
+        ASSERT_TRUE(tail);
+        EXPECT_TRUE(std::equal(tail->begin(), tail->end(), expected->begin() + static_cast<std::ptrdiff_t>(entry.length / 2), expected->end()));
+        std::vector<std::byte> buffer(entry.length - entry.length / 2 + 1);
+        EXPECT_FALSE(vpk->readEntryRangeInto(entry, entry.length / 2, buffer));
+
+        // Starting past the end fails for both
+        EXPECT_FALSE(vpk->readEntryRange(entry, entry.length + 1, 1));
+        EXPECT_FALSE(vpk->readEntryRange(entry, entry.length + 1, 0));
+        buffer.clear();
+        EXPECT_FALSE(vpk->readEntryRangeInto(entry, entry.length + 1, buffer));
+    }
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, openEntryStream) {
+    const auto root = test::makeTestDirectory("vpkedit_test_open_entry_stream");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+
+    for (const auto& entry : test::collectEntries(*vpk)) {
+        const auto expected = vpk->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        // Odd chunk sizes make reads land across where the preloaded bytes stop
+        for (std::size_t chunkSize : {1, 7, 1000, 4096}) {
+            auto stream = vpk->openEntryStream(entry);
+            ASSERT_TRUE(stream);
+            EXPECT_EQ(stream->size(), entry.length);
+            const auto data = test::readToEnd(*stream, chunkSize);
+            ASSERT_TRUE(data);
+            EXPECT_TRUE(*data == *expected);
+            EXPECT_EQ(stream->tell(), entry.length);
+        }
+
+        auto stream = vpk->openEntryStream(entry);
+        ASSERT_TRUE(stream);
+        for (const auto& [offset, length] : test::getEdgeRanges(entry.length, {entry.vpk_preloadedData.size(), 100, VPK_MAX_PRELOAD_BYTES})) {
+            ASSERT_TRUE(stream->seek(offset));
+            std::vector<std::byte> buffer(length);
+            const auto read = stream->read(buffer);
+            ASSERT_TRUE(read);
+            EXPECT_EQ(*read, length);
+            EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), expected->begin() + static_cast<std::ptrdiff_t>(offset)));
+            EXPECT_EQ(stream->tell(), offset + length);
+        }
+
+        // Reads at the end come back empty, and seeking past it is refused without moving
+        std::vector<std::byte> buffer(16);
+        ASSERT_TRUE(stream->seek(entry.length));
+        EXPECT_EQ(stream->read(buffer), 0);
+        EXPECT_FALSE(stream->seek(entry.length + 1));
+        EXPECT_EQ(stream->tell(), entry.length);
+    }
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, readEntries) {
+    const auto root = test::makeTestDirectory("vpkedit_test_read_entries");
+    // Over 16MiB of data, more than the batch keeps in flight at once
+    test::writeRandomFiles(root / "content", 400, 3333, 0, 100000, [](int i) {
+        return "dir" + std::to_string(i % 4) + "/file" + std::to_string(i) + (i % 5 ? ".bin" : ".vmt");
+    });
+    // Bigger than the longest run a batch reads in one go
+    test::writeRandomFiles(root / "content", 2, 4444, 1536 * 1024, 1536 * 1024, [](int i) {
+        return "dir1/big" + std::to_string(i) + ".bin";
+    });
+
+    PackFileOptions options;
+    options.vpk_preferredChunkSize = 8 * 1024 * 1024;
+    const auto path = (root / "pak01_dir.vpk").string();
+    ASSERT_TRUE(VPK::createFromDirectoryProcedural(path, (root / "content").string(), ::mixedEntryPlacement, options));
+
+    // The synchronous fallback is what runs where io_uring isn't available
+    for (bool async : {true, false}) {
+        options.asyncBatchReads = async;
+        auto vpk = VPK::open(path, options);
+        ASSERT_TRUE(vpk);
+        vpk->addEntry("unbaked/file.bin", test::randomBytes(5000, 1), {});
+
+        // Skipping some entries leaves gaps between the rest, some small enough to read through and some not
+        auto entries = test::collectEntries(*vpk);
+        ASSERT_EQ(entries.size(), 403);
+        std::vector<Entry> scattered;
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            if (i % 7 != 3 && i % 11 != 5) {
+                scattered.push_back(entries[i]);
+            }
+        }
+        std::shuffle(scattered.begin(), scattered.end(), std::mt19937{5555});
+
+        std::map<std::string, int> calls;
+        vpk->readEntries(scattered, [&vpk, &calls](const Entry& entry, std::optional<std::span<const std::byte>> data) {
+            calls[entry.path]++;
+            ASSERT_TRUE(data);
+            const auto expected = vpk->readEntry(entry);
+            ASSERT_TRUE(expected);
+            EXPECT_TRUE(std::equal(data->begin(), data->end(), expected->begin(), expected->end()));
+        });
+        ASSERT_EQ(calls.size(), scattered.size());
+        for (const auto& [entryPath, count] : calls) {
+            EXPECT_EQ(count, 1);
+        }
+
+        // Entries in a missing archive fail, the rest still come through
+        const auto missingCount = std::count_if(entries.begin(), entries.end(), [](const Entry& entry) {
+            return !entry.unbaked && entry.vpk_archiveIndex == 1;
+        });
+        ASSERT_TRUE(missingCount > 0);
+        const auto archivePath = root / "pak01_001.vpk";
+        std::filesystem::rename(archivePath, root / "moved.vpk");
+        // The archive is already open in the first pack file
+        auto reopened = VPK::open(path, options);
+        ASSERT_TRUE(reopened);
+        const auto reopenedEntries = test::collectEntries(*reopened);
+        std::ptrdiff_t failed = 0;
+        calls.clear();
+        reopened->readEntries(reopenedEntries, [&failed, &calls](const Entry& entry, std::optional<std::span<const std::byte>> data) {
+            calls[entry.path]++;
+            if (!data) {
+                EXPECT_EQ(entry.vpk_archiveIndex, 1);
+                failed++;
+            }
+        });
+        std::filesystem::rename(root / "moved.vpk", archivePath);
+        EXPECT_EQ(calls.size(), reopenedEntries.size());
+        EXPECT_EQ(failed, missingCount);
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, extractAll) {
+    const auto root = test::makeTestDirectory("vpkedit_test_extract_all");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+    // Stored data, preloaded bytes or not, is copied straight from the archive on Linux
+    test::checkExtractAll(*vpk, root / "out");
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(VPK, bakeCallback) {
+    const auto root = test::makeTestDirectory("vpkedit_test_bake_callback");
+    auto vpk = ::openMixedVPK(root);
+    ASSERT_TRUE(vpk);
+    EntryOptions saveToDirectory;
+    saveToDirectory.vpk_saveToDirectory = true;
+    vpk->addEntry("unbaked/directory.bin", test::randomBytes(3000, 3), saveToDirectory);
+    EntryOptions preloadEverything;
+    preloadEverything.vpk_preloadBytes = VPK_MAX_PRELOAD_BYTES;
+    vpk->addEntry("unbaked/preloaded.bin", test::randomBytes(500, 4), preloadEverything);
+    const auto entryCount = vpk->getEntryCount();
+
+    // Every entry is reported once with where its data ended up, one at a time
+    std::map<std::string, std::pair<std::uint16_t, std::uint64_t>> reported;
+    std::atomic<bool> inCallback = false;
+    ASSERT_TRUE(vpk->bake("", [&reported, &inCallback](const std::string& directory, const Entry& entry) {
+        EXPECT_FALSE(inCallback.exchange(true));
+        EXPECT_EQ(directory, entry.getParentPath());
+        EXPECT_FALSE(reported.contains(entry.path));
+        reported[entry.path] = {entry.vpk_archiveIndex, entry.offset};
+        inCallback = false;
+    }));
+    EXPECT_EQ(reported.size(), entryCount);
+
+    vpk = VPK::open((root / "pak01_dir.vpk").string());
+    ASSERT_TRUE(vpk);
+    for (const auto& entry : test::collectEntries(*vpk)) {
+        ASSERT_TRUE(reported.contains(entry.path));
+        EXPECT_EQ(reported[entry.path].first, entry.vpk_archiveIndex);
+        EXPECT_EQ(reported[entry.path].second, entry.offset);
+    }
+
+    // An entry whose data couldn't be copied isn't reported
+    test::writeRandomFiles(root / "missing", 1, 5, 3000, 3000, [](int) {
+        return std::string{"missing.bin"};
+    });
+    vpk->addEntry("unbaked/missing.bin", (root / "missing" / "missing.bin").string(), saveToDirectory);
+    std::filesystem::remove_all(root / "missing");
+    reported.clear();
+    EXPECT_FALSE(vpk->bake("", [&reported](const std::string&, const Entry& entry) {
+        reported[entry.path] = {entry.vpk_archiveIndex, entry.offset};
+    }));
+    EXPECT_FALSE(reported.contains("unbaked/missing.bin"));
+
+    vpk.reset();
+    std::filesystem::remove_all(root);
+}
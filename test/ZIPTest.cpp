@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+
+#include <vpkedit/detail/CRC32.h>
+#include <vpkedit/ZIP.h>
+
+#include "TestHelpers.h"
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace vpkedit;
+
+namespace {
+
+/// Bake a ZIP holding count entries of random data, every other one compressed with LZMA
+std::string makeZIP(const std::filesystem::path& root, int count, std::uint32_t seed) {
+    const auto path = (root / "test.zip").string();
+    {
+        // Just the end of central directory record, there's no way to create a ZIP from scratch
+        const std::array<char, 22> empty{0x50, 0x4b, 0x05, 0x06};
+        std::ofstream{path, std::ios::binary}.write(empty.data(), empty.size());
+    }
+    auto zip = ZIP::open(path);
+    if (!zip) {
+        return "";
+    }
+    std::mt19937 random{seed};
+    for (int i = 0; i < count; i++) {
+        EntryOptions options;
+        options.zip_compressionMethod = i % 2 ? MZ_COMPRESS_METHOD_LZMA : MZ_COMPRESS_METHOD_STORE;
+        zip->addEntry("dir" + std::to_string(i % 8) + "/file" + std::to_string(i) + ".bin", test::randomBytes(random() % 100000 + 1, random), options);
+    }
+    if (!zip->bake("", nullptr)) {
+        return "";
+    }
+    return path;
+}
+
+/// Where an entry's data starts, right after its local file header
+std::uint64_t getEntryDataOffset(const std::string& path, const Entry& entry) {
+    std::array<unsigned char, 30> header{};
+    std::ifstream file{path, std::ios::binary};
+    file.seekg(static_cast<std::streamoff>(entry.offset));
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+    const auto filenameLength = header[26] | header[27] << 8;
+    const auto extraFieldLength = header[28] | header[29] << 8;
+    return entry.offset + header.size() + filenameLength + extraFieldLength;
+}
+
+} // namespace
+
+TEST(ZIP, concurrentReads) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_concurrent_reads");
+    const auto path = ::makeZIP(root, 128, 1234);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+
+    std::vector<Entry> entries;
+    zip->runForAllEntries([&entries](const std::string&, const Entry& entry) {
+        entries.push_back(entry);
+    });
+    ASSERT_EQ(entries.size(), 128);
+
+    // Read everything once up front, ranges are compared against it
+    std::map<std::string, std::vector<std::byte>> contents;
+    for (const auto& entry : entries) {
+        auto data = zip->readEntry(entry);
+        ASSERT_TRUE(data);
+        ASSERT_EQ(detail::computeCRC32(*data), entry.crc32);
+        contents[entry.path] = std::move(*data);
+    }
+
+    // Compressed entries are decoded by minizip, each thread has to get a reader of its own
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&zip, &entries, &contents, &failures, t] {
+            std::mt19937 random(t);
+            std::vector<std::byte> buffer(7777);
+            for (int pass = 0; pass < 2; pass++) {
+                // Every thread walks the entries in a different order so reads collide all over the place
+                for (std::size_t i = 0; i < entries.size(); i++) {
+                    const auto& entry = entries[(i * (t * 2 + 1) + pass * 31) % entries.size()];
+                    const auto& expected = contents.at(entry.path);
+                    bool ok;
+                    switch ((i + t) % 3) {
+                        case 0: {
+                            auto data = zip->readEntry(entry);
+                            ok = data && detail::computeCRC32(*data) == entry.crc32;
+                            break;
+                        }
+                        case 1: {
+                            const auto offset = random() % entry.length;
+                            const auto length = random() % (entry.length - offset + 1);
+                            auto data = zip->readEntryRange(entry, offset, length);
+                            ok = data && std::equal(data->begin(), data->end(), expected.begin() + static_cast<std::ptrdiff_t>(offset), expected.begin() + static_cast<std::ptrdiff_t>(offset + length));
+                            break;
+                        }
+                        default: {
+                            auto stream = zip->openEntryStream(entry);
+                            ok = static_cast<bool>(stream);
+                            std::uint32_t crc32 = 0;
+                            while (ok) {
+                                auto bytesRead = stream->read(buffer);
+                                if (!bytesRead || !*bytesRead) {
+                                    ok = bytesRead.has_value();
+                                    break;
+                                }
+                                crc32 = detail::computeCRC32(buffer.data(), *bytesRead, crc32);
+                            }
+                            ok = ok && crc32 == entry.crc32;
+                            break;
+                        }
+                    }
+                    if (!ok) {
+                        failures++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, verifyEntryChecksums) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_verify");
+    const auto path = ::makeZIP(root, 64, 5678);
+    ASSERT_FALSE(path.empty());
+
+    std::vector<Entry> corrupted;
+    {
+        auto zip = ZIP::open(path);
+        ASSERT_TRUE(zip);
+        EXPECT_TRUE(test::findBadEntries(*zip, test::chunkedVerifyOptions()).empty());
+        EXPECT_TRUE(test::findBadEntries(*zip, test::chunkedVerifyOptions(1)).empty());
+
+        // A few of each, stored entries are hashed straight from the file and compressed ones are decoded first
+        int stored = 0, compressed = 0;
+        zip->runForAllEntries([&corrupted, &stored, &compressed](const std::string&, const Entry& entry) {
+            auto& count = entry.zip_compressionMethod == MZ_COMPRESS_METHOD_STORE ? stored : compressed;
+            if (entry.length > 8000 && count < 3) {
+                corrupted.push_back(entry);
+                count++;
+            }
+        });
+        ASSERT_EQ(corrupted.size(), 6);
+    }
+
+    const auto expected = test::corruptEntries(corrupted, [&path](const Entry& entry) {
+        return std::pair{std::filesystem::path{path}, ::getEntryDataOffset(path, entry) + entry.compressedLength / 2};
+    });
+
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    EXPECT_EQ(test::findBadEntries(*zip, test::chunkedVerifyOptions()), expected);
+    EXPECT_EQ(test::findBadEntries(*zip, test::chunkedVerifyOptions(1)), expected);
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, readEntryView) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_read_entry_view");
+    const auto path = ::makeZIP(root, 16, 4321);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    zip->addEntry("unbaked/file.bin", test::randomBytes(3000, 1), {});
+    const auto entries = test::collectEntries(*zip);
+    ASSERT_EQ(entries.size(), 17);
+
+    for (const auto& entry : entries) {
+        const auto expected = zip->readEntry(entry);
+        ASSERT_TRUE(expected);
+        auto view = zip->readEntryView(entry);
+        ASSERT_TRUE(view);
+        EXPECT_TRUE(std::equal(view->begin(), view->end(), expected->begin(), expected->end()));
+        // Compressed data has to be inflated into a copy
+        EXPECT_EQ(view->isMapped(), !entry.unbaked && entry.zip_compressionMethod == MZ_COMPRESS_METHOD_STORE);
+    }
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, readEntryInto) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_read_entry_into");
+    const auto path = ::makeZIP(root, 16, 5678);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    zip->addEntry("unbaked/file.bin", test::randomBytes(3000, 1), {});
+
+    std::vector<std::byte> reused;
+    for (const auto& entry : test::collectEntries(*zip)) {
+        const auto expected = zip->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        std::vector<std::byte> bigger(entry.length + 16);
+        EXPECT_TRUE(zip->readEntryInto(entry, std::span{bigger}));
+        EXPECT_TRUE(std::equal(expected->begin(), expected->end(), bigger.begin()));
+
+        std::vector<std::byte> smaller(entry.length - 1);
+        EXPECT_FALSE(zip->readEntryInto(entry, std::span{smaller}));
+
+        EXPECT_TRUE(zip->readEntryInto(entry, reused));
+        EXPECT_TRUE(reused == *expected);
+    }
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, readEntryRange) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_read_entry_range");
+    const auto path = ::makeZIP(root, 16, 8765);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    zip->addEntry("unbaked/file.bin", test::randomBytes(3000, 1), {});
+
+    for (const auto& entry : test::collectEntries(*zip)) {
+        const auto expected = zip->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        for (const auto& [offset, length] : test::getEdgeRanges(entry.length)) {
+            const auto begin = expected->begin() + static_cast<std::ptrdiff_t>(offset);
+            const auto range = zip->readEntryRange(entry, offset, length);
+            ASSERT_TRUE(range);
+            EXPECT_TRUE(std::equal(range->begin(), range->end(), begin, begin + static_cast<std::ptrdiff_t>(length)));
+
+            std::vector<std::byte> buffer(length);
+            EXPECT_TRUE(zip->readEntryRangeInto(entry, offset, buffer));
+            EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), begin, begin + static_cast<std::ptrdiff_t>(length)));
+        }
+
+        const auto tail = zip->readEntryRange(entry, entry.length - 1, 100);
+        ASSERT_TRUE(tail);
+        ASSERT_EQ(tail->size(), 1);
+        EXPECT_EQ(tail->front(), expected->back());
+        std::vector<std::byte> buffer(2);
+        EXPECT_FALSE(zip->readEntryRangeInto(entry, entry.length - 1, buffer));
+        EXPECT_FALSE(zip->readEntryRange(entry, entry.length + 1, 1));
+    }
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, openEntryStream) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_open_entry_stream");
+    const auto path = ::makeZIP(root, 16, 9876);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    zip->addEntry("unbaked/file.bin", test::randomBytes(3000, 1), {});
+
+    for (const auto& entry : test::collectEntries(*zip)) {
+        const auto expected = zip->readEntry(entry);
+        ASSERT_TRUE(expected);
+
+        for (std::size_t chunkSize : {7, 4096, 65536}) {
+            auto stream = zip->openEntryStream(entry);
+            ASSERT_TRUE(stream);
+            EXPECT_EQ(stream->size(), entry.length);
+            const auto data = test::readToEnd(*stream, chunkSize);
+            ASSERT_TRUE(data);
+            EXPECT_TRUE(*data == *expected);
+        }
+
+        // Compressed entries have to be inflated up to where a seek lands, going backward included
+        auto stream = zip->openEntryStream(entry);
+        ASSERT_TRUE(stream);
+        for (const auto offset : {entry.length / 2, std::uint64_t{0}, entry.length - 1}) {
+            ASSERT_TRUE(stream->seek(offset));
+            std::vector<std::byte> buffer(std::min<std::uint64_t>(100, entry.length - offset));
+            EXPECT_EQ(stream->read(buffer), buffer.size());
+            EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), expected->begin() + static_cast<std::ptrdiff_t>(offset)));
+        }
+        std::vector<std::byte> buffer(16);
+        EXPECT_EQ(stream->read(buffer), 0);
+        EXPECT_FALSE(stream->seek(entry.length + 1));
+    }
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
+
+TEST(ZIP, extractAll) {
+    const auto root = test::makeTestDirectory("vpkedit_test_zip_extract_all");
+    const auto path = ::makeZIP(root, 16, 2468);
+    ASSERT_FALSE(path.empty());
+    auto zip = ZIP::open(path);
+    ASSERT_TRUE(zip);
+    zip->addEntry("unbaked/file.bin", test::randomBytes(30000, 1), {});
+    // Stored entries are copied straight from the ZIP on Linux, compressed ones have to be inflated
+    test::checkExtractAll(*zip, root / "out");
+
+    zip.reset();
+    std::filesystem::remove_all(root);
+}
@@ -7,7 +7,13 @@ FetchContent_MakeAvailable(googletest)
 enable_testing()
 
 add_executable(${PROJECT_NAME}test
-        "${CMAKE_CURRENT_LIST_DIR}/VPKTest.cpp")
+        "${CMAKE_CURRENT_LIST_DIR}/ChecksumTest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/EntryTableTest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/FileStreamTest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/GCFTest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/GMATest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/VPKTest.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/ZIPTest.cpp")
 
 target_link_libraries(${PROJECT_NAME}test PUBLIC lib${PROJECT_NAME} gtest_main)
 